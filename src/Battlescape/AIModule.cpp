@@ -1118,30 +1118,32 @@ int AIModule::getSpottingUnits(const Position& pos) const
 {
 	// if we don't actually occupy the position being checked, we need to do a virtual LOF check.
 	bool checking = pos != _unit->getPosition();
-	int tally = 0;
-	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	std::vector<TileEngine::TargetUnitQuery> queries;
+	std::vector<BattleUnit*> nearUnits;
+	_save->getUnitsInRadius(pos, 20, nearUnits);
+	for (BattleUnit *spotter : nearUnits)
 	{
-		if (validTarget(*i, false, false))
+		if (validTarget(spotter, false, false))
 		{
-			int dist = Position::distance2d(pos, (*i)->getPosition());
+			int dist = Position::distance2d(pos, spotter->getPosition());
 			if (dist > 20) continue;
-			Position originVoxel = _save->getTileEngine()->getSightOriginVoxel(*i);
-			originVoxel.z -= 2;
-			Position targetVoxel;
-			if (checking)
-			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false, _unit))
-				{
-					tally++;
-				}
-			}
-			else
-			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, *i, false))
-				{
-					tally++;
-				}
-			}
+			TileEngine::TargetUnitQuery query = { };
+			query.originVoxel = _save->getTileEngine()->getSightOriginVoxel(spotter);
+			query.originVoxel.z -= 2;
+			query.tile = _save->getTile(pos);
+			query.excludeUnit = spotter;
+			query.potentialUnit = checking ? _unit : nullptr;
+			queries.push_back(query);
+		}
+	}
+	_save->getTileEngine()->canTargetUnits(queries);
+
+	int tally = 0;
+	for (auto& q : queries)
+	{
+		if (q.result)
+		{
+			tally++;
 		}
 	}
 	return tally;
@@ -1158,13 +1160,16 @@ int AIModule::selectNearestTarget()
 	_closestDist= 100;
 	_aggroTarget = 0;
 	Position target;
-	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	// units of own faction are always visible, others only up to max view distance
+	std::vector<BattleUnit*> nearUnits;
+	_save->getUnitsInRadius(_unit->getPosition(), _save->getMod()->getMaxViewDistance(), nearUnits, SavedBattleGame::UNIT_INDEX_ALL_FACTIONS, 1 << _unit->getFaction());
+	for (BattleUnit *candidate : nearUnits)
 	{
-		if (validTarget(*i, true, _unit->getFaction() == FACTION_HOSTILE) &&
-			_save->getTileEngine()->visible(_unit, (*i)->getTile()))
+		if (validTarget(candidate, true, _unit->getFaction() == FACTION_HOSTILE) &&
+			_save->getTileEngine()->visible(_unit, candidate->getTile()))
 		{
 			tally++;
-			int dist = Position::distance2d(_unit->getPosition(), (*i)->getPosition());
+			int dist = Position::distance2d(_unit->getPosition(), candidate->getPosition());
 			if (dist < _closestDist)
 			{
 				bool valid = false;
@@ -1173,22 +1178,22 @@ int AIModule::selectNearestTarget()
 					BattleAction action;
 					action.actor = _unit;
 					action.weapon = _attackAction.weapon;
-					action.target = (*i)->getPosition();
+					action.target = candidate->getPosition();
 					Position origin = _save->getTileEngine()->getOriginVoxel(action, 0);
-					valid = _save->getTileEngine()->canTargetUnit(&origin, (*i)->getTile(), &target, _unit, false);
+					valid = _save->getTileEngine()->canTargetUnit(&origin, candidate->getTile(), &target, _unit, false);
 				}
 				else
 				{
-					if (selectPointNearTarget(*i, _unit->getTimeUnits()))
+					if (selectPointNearTarget(candidate, _unit->getTimeUnits()))
 					{
-						int dir = _save->getTileEngine()->getDirectionTo(_attackAction.target, (*i)->getPosition());
-						valid = _save->getTileEngine()->validMeleeRange(_attackAction.target, dir, _unit, *i, 0);
+						int dir = _save->getTileEngine()->getDirectionTo(_attackAction.target, candidate->getPosition());
+						valid = _save->getTileEngine()->validMeleeRange(_attackAction.target, dir, _unit, candidate, 0);
 					}
 				}
 				if (valid)
 				{
 					_closestDist = dist;
-					_aggroTarget = *i;
+					_aggroTarget = candidate;
 				}
 			}
 		}
@@ -1212,25 +1217,28 @@ int AIModule::selectNearestTargetLeeroy(bool canRun)
 	int tally = 0;
 	_closestDist = 100;
 	_aggroTarget = 0;
-	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	// units of own faction are always visible, others only up to max view distance
+	std::vector<BattleUnit*> nearUnits;
+	_save->getUnitsInRadius(_unit->getPosition(), _save->getMod()->getMaxViewDistance(), nearUnits, SavedBattleGame::UNIT_INDEX_ALL_FACTIONS, 1 << _unit->getFaction());
+	for (BattleUnit *candidate : nearUnits)
 	{
-		if (validTarget(*i, true, _unit->getFaction() == FACTION_HOSTILE) &&
-			_save->getTileEngine()->visible(_unit, (*i)->getTile()))
+		if (validTarget(candidate, true, _unit->getFaction() == FACTION_HOSTILE) &&
+			_save->getTileEngine()->visible(_unit, candidate->getTile()))
 		{
 			tally++;
-			int dist = Position::distance2d(_unit->getPosition(), (*i)->getPosition());
+			int dist = Position::distance2d(_unit->getPosition(), candidate->getPosition());
 			if (dist < _closestDist)
 			{
 				bool valid = false;
-				if (selectPointNearTargetLeeroy(*i, canRun))
+				if (selectPointNearTargetLeeroy(candidate, canRun))
 				{
-					int dir = _save->getTileEngine()->getDirectionTo(_attackAction.target, (*i)->getPosition());
-					valid = _save->getTileEngine()->validMeleeRange(_attackAction.target, dir, _unit, *i, 0);
+					int dir = _save->getTileEngine()->getDirectionTo(_attackAction.target, candidate->getPosition());
+					valid = _save->getTileEngine()->validMeleeRange(_attackAction.target, dir, _unit, candidate, 0);
 				}
 				if (valid)
 				{
 					_closestDist = dist;
-					_aggroTarget = *i;
+					_aggroTarget = candidate;
 				}
 			}
 		}
@@ -1825,13 +1833,16 @@ bool AIModule::findFirePoint()
 		return false;
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
 	RNG::shuffle(randomTileSearch);
-	Position target;
 	const int BASE_SYSTEMATIC_SUCCESS = 100;
 	const int FAST_PASS_THRESHOLD = 125;
 	bool waitIfOutsideWeaponRange = _unit->getGeoscapeSoldier() ? false : _unit->getUnitRules()->waitIfOutsideWeaponRange();
 	bool extendedFireModeChoiceEnabled = _save->getBattleGame()->getMod()->getAIExtendedFireModeChoice();
 	int bestScore = 0;
 	_attackAction.type = BA_RETHINK;
+
+	// check lines of fire from all candidate tiles at once, they do not depend on each other
+	std::vector<Position> positions;
+	std::vector<TileEngine::TargetUnitQuery> queries;
 	for (std::vector<Position>::const_iterator i = randomTileSearch.begin(); i != randomTileSearch.end(); ++i)
 	{
 		Position pos = _unit->getPosition() + *i;
@@ -1839,13 +1850,24 @@ bool AIModule::findFirePoint()
 		if (tile == 0  ||
 			std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end())
 			continue;
-		int score = 0;
+		TileEngine::TargetUnitQuery query = { };
 		// i should really make a function for this
-		Position origin = pos.toVoxel() +
+		query.originVoxel = pos.toVoxel() +
 			// 4 because -2 is eyes and 2 below that is the rifle (or at least that's my understanding)
 			Position(8,8, _unit->getHeight() + _unit->getFloatHeight() - tile->getTerrainLevel() - 4);
+		query.tile = _aggroTarget->getTile();
+		query.excludeUnit = _unit;
+		positions.push_back(pos);
+		queries.push_back(query);
+	}
+	_save->getTileEngine()->canTargetUnits(queries);
+
+	for (size_t i = 0; i < queries.size(); ++i)
+	{
+		Position pos = positions[i];
+		int score = 0;
 
-		if (_save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &target, _unit, false))
+		if (queries[i].result)
 		{
 			_save->getPathfinding()->calculate(_unit, pos, BAM_NORMAL);
 			// can move here
@@ -193,7 +193,8 @@ bool BattleActionCost::spendTU(std::string *message)
  */
 BattlescapeGame::BattlescapeGame(SavedBattleGame *save, BattlescapeState *parentState) :
 	_save(save), _parentState(parentState),
-	_playerPanicHandled(true), _AIActionCounter(0), _AISecondMove(false), _playedAggroSound(false),
+	_playerPanicHandled(true), _AIActionCounter(0), _AISecondMove(false), _playedAggroSound(false), _AIRethink(false),
+	_AIThinking(false), _AIStart(false), _AIDone(false), _AIQuit(false),
 	_endTurnRequested(false), _endConfirmationHandled(false), _allEnemiesNeutralized(false)
 {
 	if (_save->isPreview())
@@ -218,6 +219,15 @@ BattlescapeGame::BattlescapeGame(SavedBattleGame *save, BattlescapeState *parent
  */
 BattlescapeGame::~BattlescapeGame()
 {
+	if (_AIThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_AIMutex);
+			_AIQuit = true;
+		}
+		_AIWake.notify_one();
+		_AIThread.join();
+	}
 	for (std::list<BattleState*>::iterator i = _states.begin(); i != _states.end(); ++i)
 	{
 		delete *i;
@@ -230,6 +240,28 @@ BattlescapeGame::~BattlescapeGame()
  */
 void BattlescapeGame::think()
 {
+	// AI is still deciding, nothing can change until it's done
+	if (_AIThinking)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_AIMutex);
+			if (!_AIDone)
+			{
+				return;
+			}
+			_AIDone = false;
+		}
+		_AIThinking = false;
+		if (_AIError)
+		{
+			std::exception_ptr error = _AIError;
+			_AIError = nullptr;
+			std::rethrow_exception(error);
+		}
+		finishAI(_AIAction.actor);
+		return;
+	}
+
 	// nothing is happening - see if we need some alien AI or units panicking or what have you
 	if (_states.empty())
 	{
@@ -298,8 +330,6 @@ void BattlescapeGame::init()
  */
 void BattlescapeGame::handleAI(BattleUnit *unit)
 {
-	std::ostringstream ss;
-
 	if (unit->getTimeUnits() <= 5)
 	{
 		unit->dontReselect();
@@ -354,15 +384,91 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 		if (Options::traceAI) { Log(LOG_INFO) << "#" << unit->getId() << "--" << unit->getType(); }
 	}
 
-	BattleAction action;
-	action.actor = unit;
-	action.number = _AIActionCounter;
-	unit->think(&action);
+	_AIAction = BattleAction();
+	_AIAction.actor = unit;
+	_AIAction.number = _AIActionCounter;
+	if (Options::oxceBackgroundAI)
+	{
+		// long decisions would freeze the screen, let the game loop run until AI is done
+		_save->getTileEngine()->prepareTerrainVoxels();
+		if (!_AIThread.joinable())
+		{
+			_AIThread = std::thread(&BattlescapeGame::workAI, this);
+		}
+		{
+			std::lock_guard<std::mutex> lock(_AIMutex);
+			_AIStart = true;
+		}
+		_AIWake.notify_one();
+		_AIThinking = true;
+		return;
+	}
+	thinkAI(unit);
+	finishAI(unit);
+}
 
-	if (action.type == BA_RETHINK)
+/**
+ * Lets the AI decide what unit should do.
+ * Can run on other thread, so it must not touch anything but the AI of the unit, UI waits until it's done.
+ * @param unit Pointer to a unit.
+ */
+void BattlescapeGame::thinkAI(BattleUnit *unit)
+{
+	_AIRethink = false;
+	unit->think(&_AIAction);
+
+	if (_AIAction.type == BA_RETHINK)
+	{
+		_AIRethink = true;
+		unit->think(&_AIAction);
+	}
+}
+
+/**
+ * Waits for AI decisions to make and runs them, until game is over.
+ * Errors are given back to main thread that rethrows them.
+ */
+void BattlescapeGame::workAI()
+{
+	std::unique_lock<std::mutex> lock(_AIMutex);
+	while (true)
+	{
+		_AIWake.wait(lock, [this]{ return _AIStart || _AIQuit; });
+		if (_AIQuit)
+		{
+			return;
+		}
+		_AIStart = false;
+		lock.unlock();
+
+		std::exception_ptr error;
+		try
+		{
+			thinkAI(_AIAction.actor);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		_AIError = error;
+		_AIDone = true;
+	}
+}
+
+/**
+ * Carries out the decision of the AI.
+ * @param unit Pointer to a unit.
+ */
+void BattlescapeGame::finishAI(BattleUnit *unit)
+{
+	std::ostringstream ss;
+	BattleAction &action = _AIAction;
+
+	if (_AIRethink)
 	{
 		_parentState->debug("Rethink");
-		unit->think(&action);
 	}
 
 	_AIActionCounter = action.number;
@@ -22,6 +22,10 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 namespace OpenXcom
 {
@@ -172,6 +176,14 @@ private:
 	int _AIActionCounter;
 	BattleAction _currentAction;
 	bool _AISecondMove, _playedAggroSound;
+	BattleAction _AIAction;
+	bool _AIRethink;
+	/// Thread deciding AI actions, started on first use and reused for all decisions.
+	std::thread _AIThread;
+	std::mutex _AIMutex;
+	std::condition_variable _AIWake;
+	bool _AIThinking, _AIStart, _AIDone, _AIQuit;
+	std::exception_ptr _AIError;
 	bool _endTurnRequested;
 	bool _endConfirmationHandled;
 	bool _allEnemiesNeutralized;
@@ -185,6 +197,12 @@ private:
 	bool handlePanickingPlayer();
 	/// Common function for handling panicking units.
 	bool handlePanickingUnit(BattleUnit *unit);
+	/// Lets the AI decide what unit should do.
+	void thinkAI(BattleUnit *unit);
+	/// Main loop of AI thread.
+	void workAI();
+	/// Carries out the decision of the AI.
+	void finishAI(BattleUnit *unit);
 	/// Determines whether there are any actions pending for the given unit.
 	bool noActionsPending(BattleUnit *bu);
 	std::vector<InfoboxOKState*> _infoboxQueue;
@@ -256,6 +274,8 @@ public:
 	BattleAction *getCurrentAction();
 	/// Determines whether there is an action currently going on.
 	bool isBusy() const;
+	/// Is the AI deciding on other thread?
+	bool isAIThinking() const { return _AIThinking; }
 	/// Activates primary action (left click).
 	void primaryAction(Position pos);
 	/// Activates secondary action (right click).
@@ -2536,6 +2536,21 @@ void BattlescapeGenerator::fuelPowerSources()
  */
 void BattlescapeGenerator::explodePowerSources()
 {
+	// with explosion waves lighting and visibility are updated once for area of all explosions
+	const bool waves = Options::oxceExplosionWaves;
+	Position areaMin = TileEngine::invalid, areaMax = TileEngine::invalid;
+	int maxRadius = 0;
+	auto addToArea = [&](Position pos, int radius)
+	{
+		if (areaMin == TileEngine::invalid)
+		{
+			areaMin = areaMax = pos;
+		}
+		areaMin = Position(std::min(areaMin.x, pos.x), std::min(areaMin.y, pos.y), std::min(areaMin.z, pos.z));
+		areaMax = Position(std::max(areaMax.x, pos.x), std::max(areaMax.y, pos.y), std::max(areaMax.z, pos.z));
+		maxRadius = std::max(maxRadius, radius);
+	};
+
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
 		if (_save->getTile(i)->getObjectSpecialTileType() == UFO_POWER_SOURCE && RNG::percent(75))
@@ -2544,17 +2559,42 @@ void BattlescapeGenerator::explodePowerSources()
 			pos.x = _save->getTile(i)->getPosition().x*16;
 			pos.y = _save->getTile(i)->getPosition().y*16;
 			pos.z = (_save->getTile(i)->getPosition().z*24) +12;
-			_save->getTileEngine()->explode({ }, pos, 180+RNG::generate(0,70), _save->getMod()->getDamageType(DT_HE), 10);
+			_save->getTileEngine()->explode({ }, pos, 180+RNG::generate(0,70), _save->getMod()->getDamageType(DT_HE), 10, true, !waves);
+			addToArea(pos.toTile(), 10);
+		}
+	}
+
+	if (!waves)
+	{
+		Tile *t = _save->getTileEngine()->checkForTerrainExplosions();
+		while (t)
+		{
+			int power = t->getExplosive();
+			t->setExplosive(0, 0, true);
+			Position p = t->getPosition().toVoxel() + Position(8,8,0);
+			_save->getTileEngine()->explode({ }, p, power, _game->getMod()->getDamageType(DT_HE), power / 10);
+			t = _save->getTileEngine()->checkForTerrainExplosions();
+		}
+		return;
+	}
+
+	std::vector<Tile*> wave;
+	_save->getTileEngine()->checkForTerrainExplosions(wave);
+	while (!wave.empty())
+	{
+		for (Tile *t : wave)
+		{
+			int power = t->getExplosive();
+			t->setExplosive(0, 0, true);
+			Position p = t->getPosition().toVoxel() + Position(8,8,0);
+			_save->getTileEngine()->explode({ }, p, power, _game->getMod()->getDamageType(DT_HE), power / 10, true, false);
+			addToArea(t->getPosition(), power / 10);
 		}
+		_save->getTileEngine()->checkForTerrainExplosions(wave);
 	}
-	Tile *t = _save->getTileEngine()->checkForTerrainExplosions();
-	while (t)
+	if (areaMin != TileEngine::invalid)
 	{
-		int power = t->getExplosive();
-		t->setExplosive(0, 0, true);
-		Position p = t->getPosition().toVoxel() + Position(8,8,0);
-		_save->getTileEngine()->explode({ }, p, power, _game->getMod()->getDamageType(DT_HE), power / 10);
-		t = _save->getTileEngine()->checkForTerrainExplosions();
+		_save->getTileEngine()->updateExplosionView(areaMin, areaMax, maxRadius);
 	}
 }
 
@@ -861,8 +861,23 @@ void BattlescapeState::think()
 	{
 		if (_popups.empty())
 		{
+			if (_battleGame->isAIThinking())
+			{
+				// only wait for AI decision, battle can't change until it's done
+				_battleGame->think();
+				if (!_battleGame->isAIThinking())
+				{
+					handleHeldEvents();
+				}
+				return;
+			}
 			State::think();
 			_battleGame->think();
+			if (_battleGame->isAIThinking())
+			{
+				// AI started to decide, timers would change battle under it
+				return;
+			}
 			_animTimer->think(this, 0);
 			_gameTimer->think(this, 0);
 			if (popped)
@@ -2645,6 +2660,15 @@ std::string BattlescapeState::getMeleeDamagePreview(BattleUnit *actor, BattleIte
  */
 inline void BattlescapeState::handle(Action *action)
 {
+	if (_battleGame->isAIThinking())
+	{
+		// keys and clicks are handled when AI is done, next mouse move updates the cursor anyway
+		if (action->getDetails()->type != SDL_MOUSEMOTION)
+		{
+			_heldEvents.push_back(*action->getDetails());
+		}
+		return;
+	}
 	if (!_firstInit)
 	{
 		if (_game->getCursor()->getVisible() || ((action->getDetails()->type == SDL_MOUSEBUTTONDOWN || action->getDetails()->type == SDL_MOUSEBUTTONUP) && _game->isRightClick(action)))
@@ -2924,6 +2948,22 @@ inline void BattlescapeState::handle(Action *action)
 	}
 }
 
+/**
+ * Handles keys and clicks that came while AI was thinking,
+ * in the same order as the player gave them.
+ */
+void BattlescapeState::handleHeldEvents()
+{
+	std::vector<SDL_Event> events;
+	events.swap(_heldEvents);
+	Screen *screen = _game->getScreen();
+	for (SDL_Event &ev : events)
+	{
+		Action action = Action(&ev, screen->getXScale(), screen->getYScale(), screen->getCursorTopBlackBand(), screen->getCursorLeftBlackBand());
+		handle(&action);
+	}
+}
+
 /**
  * Saves a map as used by the AI.
  */
@@ -84,6 +84,7 @@ private:
 	Uint8 _tooltipDefaultColor;
 	Uint8 _medikitRed, _medikitGreen, _medikitBlue, _medikitOrange;
 	std::vector<State*> _popups;
+	std::vector<SDL_Event> _heldEvents;
 	BattlescapeGame *_battleGame;
 	bool _firstInit, _paletteResetNeeded, _paletteResetRequested;
 	bool _isMouseScrolling, _isMouseScrolled;
@@ -241,6 +242,8 @@ public:
 	std::string getMeleeDamagePreview(BattleUnit *actor, BattleItem *weapon) const;
 	/// Handles keypresses.
 	void handle(Action *action) override;
+	/// Handles input that came while AI was thinking.
+	void handleHeldEvents();
 	/// Displays a popup window.
 	void popup(State *state);
 	/// Finishes a battle.
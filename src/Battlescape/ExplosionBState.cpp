@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include "ExplosionBState.h"
 #include "BattlescapeState.h"
 #include "Explosion.h"
@@ -31,6 +32,7 @@
 #include "../Mod/RuleItem.h"
 #include "../Mod/Armor.h"
 #include "../Engine/RNG.h"
+#include "../Engine/Options.h"
 
 namespace OpenXcom
 {
@@ -155,25 +157,15 @@ void ExplosionBState::init()
 	}
 	else if (_tile)
 	{
-		ItemDamageType DT;
-		switch (_tile->getExplosiveType())
+		if (Options::oxceExplosionWaves)
 		{
-		case 0:
-			DT = DT_HE;
-			break;
-		case 5:
-			DT = DT_IN;
-			break;
-		case 6:
-			DT = DT_STUN;
-			break;
-		default:
-			DT = DT_SMOKE;
-			break;
+			// all other tiles that are ready to explode go off together with this one
+			_parent->getTileEngine()->checkForTerrainExplosions(_wave);
+			_wave.erase(std::remove(_wave.begin(), _wave.end(), _tile), _wave.end());
 		}
+		_damageType = getTerrainDamageType(_tile);
 		_power = _tile->getExplosive();
 		_tile->setExplosive(0, 0, true);
-		_damageType = _parent->getMod()->getDamageType(DT);
 		_radius = _power /10;
 		_areaOfEffect = true;
 	}
@@ -210,7 +202,35 @@ void ExplosionBState::init()
 	{
 		if (_power > 0)
 		{
-			_parent->getSave()->getTileEngine()->explode(_attack, _center, _power, _damageType, _radius, range);
+			TileEngine *tileEngine = _parent->getSave()->getTileEngine();
+			tileEngine->explode(_attack, _center, _power, _damageType, _radius, range, _wave.empty());
+
+			// rest of the wave, lighting and visibility are updated once for all of them
+			std::vector<std::pair<Position, int> > waveBlasts;
+			if (!_wave.empty())
+			{
+				Position areaMin = _center.toTile(), areaMax = areaMin;
+				int maxRadius = _radius;
+				for (Tile *tile : _wave)
+				{
+					const RuleDamageType *damageType = getTerrainDamageType(tile);
+					int power = tile->getExplosive();
+					tile->setExplosive(0, 0, true);
+					if (power <= 0)
+					{
+						continue;
+					}
+					Position center = tile->getPosition().toVoxel() + Position(8,8,0);
+					tileEngine->explode(_attack, center, power, damageType, power / 10, range, false);
+					waveBlasts.push_back(std::make_pair(center, power));
+
+					Position pos = tile->getPosition();
+					areaMin = Position(std::min(areaMin.x, pos.x), std::min(areaMin.y, pos.y), std::min(areaMin.z, pos.z));
+					areaMax = Position(std::max(areaMax.x, pos.x), std::max(areaMax.y, pos.y), std::max(areaMax.z, pos.z));
+					maxRadius = std::max(maxRadius, power / 10);
+				}
+				tileEngine->updateExplosionView(areaMin, areaMax, maxRadius);
+			}
 
 			int powerForAnimation = _power;
 			if (itemRule && itemRule->getPowerForAnimation() > 0)
@@ -232,22 +252,14 @@ void ExplosionBState::init()
 			{
 				frame -= (frameCount > 0 ? frameCount : Explosion::EXPLODE_FRAMES);
 			}
-			int frameDelay = 0;
-			int counter = std::max(1, (powerForAnimation / 5) / 5);
 			_parent->getMap()->setBlastFlash(true);
-			int lowerLimit = std::max(1, powerForAnimation / 5);
-			for (int i = 0; i < lowerLimit; i++)
+			addExplosionSprites(_center, powerForAnimation, frame, frameCount);
+			for (const auto &blast : waveBlasts)
 			{
-				int X = RNG::generate(-powerForAnimation / 2, powerForAnimation / 2);
-				int Y = RNG::generate(-powerForAnimation / 2, powerForAnimation / 2);
-				Position p = _center;
-				p.x += X; p.y += Y;
-				Explosion *explosion = new Explosion(p, frame, frameDelay, true, false, frameCount);
-				// add the explosion on the map
-				_parent->getMap()->getExplosions()->push_back(explosion);
-				if (i > 0 && i % counter == 0)
+				addExplosionSprites(blast.first, blast.second, frame, frameCount);
+				if (blast.second > 80)
 				{
-					frameDelay++;
+					sound = Mod::LARGE_EXPLOSION;
 				}
 			}
 			int explosionSpeed = BattlescapeState::DEFAULT_ANIM_SPEED/2;
@@ -276,7 +288,12 @@ void ExplosionBState::init()
 					{
 						int soundRange = _radius + 35;
 						int dist = std::ceil(Position::distance(unit->getPosition(), _center.toTile()));
-						if (dist <= soundRange)
+						bool heard = dist <= soundRange;
+						for (const auto &blast : waveBlasts)
+						{
+							heard = heard || std::ceil(Position::distance(unit->getPosition(), blast.first.toTile())) <= blast.second / 10 + 35;
+						}
+						if (heard)
 						{
 							unit->setUnitWarned(true);
 							Log(LOG_INFO) << "Unit is warned because explosion sound."; //#FINNIKTODO #CLEARLOGS
@@ -396,6 +413,60 @@ void ExplosionBState::init()
 	}
 }
 
+/**
+ * Adds explosion sprites around center of blast to the map.
+ * @param center Center of the blast in voxel space.
+ * @param power Power of the blast, it decides spread and number of sprites.
+ * @param frame First frame of the explosion animation.
+ * @param frameCount Number of frames of the animation, -1 for default.
+ */
+void ExplosionBState::addExplosionSprites(Position center, int power, int frame, int frameCount)
+{
+	int frameDelay = 0;
+	int counter = std::max(1, (power / 5) / 5);
+	int lowerLimit = std::max(1, power / 5);
+	for (int i = 0; i < lowerLimit; i++)
+	{
+		int X = RNG::generate(-power / 2, power / 2);
+		int Y = RNG::generate(-power / 2, power / 2);
+		Position p = center;
+		p.x += X; p.y += Y;
+		Explosion *explosion = new Explosion(p, frame, frameDelay, true, false, frameCount);
+		// add the explosion on the map
+		_parent->getMap()->getExplosions()->push_back(explosion);
+		if (i > 0 && i % counter == 0)
+		{
+			frameDelay++;
+		}
+	}
+}
+
+/**
+ * Gets damage type of explosion of terrain object.
+ * @param tile Tile that explodes.
+ * @return Damage type of the explosion.
+ */
+const RuleDamageType *ExplosionBState::getTerrainDamageType(Tile *tile) const
+{
+	ItemDamageType DT;
+	switch (tile->getExplosiveType())
+	{
+	case 0:
+		DT = DT_HE;
+		break;
+	case 5:
+		DT = DT_IN;
+		break;
+	case 6:
+		DT = DT_STUN;
+		break;
+	default:
+		DT = DT_SMOKE;
+		break;
+	}
+	return _parent->getMod()->getDamageType(DT);
+}
+
 /**
  * Animates explosion sprites. If their animation is finished remove them from the list.
  * If the list is empty, this state is finished and the actual calculations take place.
@@ -17,6 +17,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <vector>
 #include "BattleState.h"
 #include "Position.h"
 
@@ -42,6 +43,7 @@ private:
 	Position _center;
 	const RuleDamageType *_damageType;
 	Tile *_tile;
+	std::vector<Tile*> _wave;
 	BattleUnit *_targetPsiOrHit;
 	int _power;
 	int _radius;
@@ -50,6 +52,10 @@ private:
 
 	/// Calculates the effects of the explosion.
 	void explode();
+	/// Adds explosion sprites around center of blast.
+	void addExplosionSprites(Position center, int power, int frame, int frameCount);
+	/// Gets damage type of explosion of terrain object.
+	const RuleDamageType *getTerrainDamageType(Tile *tile) const;
 	/// Set new value to reference if new value is not equal -1.
 	void optValue(int &oldValue, int newValue) const;
 public:
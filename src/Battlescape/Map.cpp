@@ -22,6 +22,7 @@
 #include "ItemSprite.h"
 #include "Pathfinding.h"
 #include "TileEngine.h"
+#include "BattlescapeGame.h"
 #include "Projectile.h"
 #include "Explosion.h"
 #include "BattlescapeState.h"
@@ -109,7 +110,8 @@ Map::Map(Game *game, int width, int height, int x, int y, int visibleMapHeight)
 	_game(game), _arrow(0), _missionPointer(0), _sensorPointer(0), _anyIndicator(false), _isAltPressed(false),
 	_selectorX(0), _selectorY(0), _mouseX(0), _mouseY(0), _cursorType(CT_NORMAL), _cursorSize(1), _animFrame(0),
 	_projectile(0), _followProjectile(true), _projectileInFOV(false), _explosionInFOV(false), _launch(false), _visibleMapHeight(visibleMapHeight),
-	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _showObstacles(false)
+	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _showObstacles(false),
+	_tileShadeFrame(0), _lastTileShadeFrame(0)
 {
 	_iconHeight = _game->getMod()->getInterface("battlescape")->getElement("icons")->h;
 	_iconWidth = _game->getMod()->getInterface("battlescape")->getElement("icons")->w;
@@ -332,6 +334,11 @@ void Map::draw()
 	{
 		return;
 	}
+	if (_save->getBattleState() && _save->getBattleGame() && _save->getBattleGame()->isAIThinking())
+	{
+		// units can change while AI decides on other thread, keep last frame
+		return;
+	}
 
 	// normally we'd call for a Surface::draw();
 	// but we don't want to clear the background with colour 0, which is transparent (aka black)
@@ -883,6 +890,31 @@ void Map::drawTerrain(Surface *surface)
 		movingUnitPosition = movingUnit->getPosition();
 	}
 
+	// every tile shade is needed few times for floor, walls, objects and units
+	if ((int)_tileShades.size() != _save->getMapSizeXYZ())
+	{
+		_tileShades.assign(_save->getMapSizeXYZ(), 0);
+		_tileShadeFrames.assign(_save->getMapSizeXYZ(), 0);
+	}
+	_tileShadeFrame = ++_lastTileShadeFrame;
+	if (_tileShadeFrame == 0)
+	{
+		// counter wrapped around, old frame numbers could match again
+		std::fill(_tileShadeFrames.begin(), _tileShadeFrames.end(), 0);
+		_tileShadeFrame = _lastTileShadeFrame = 1;
+	}
+	_nightVisionUnits.clear();
+	if (_nvColor != 0)
+	{
+		for (auto* unit : *_save->getUnits())
+		{
+			if (unit->getFaction() == FACTION_PLAYER && !unit->isOut())
+			{
+				_nightVisionUnits.push_back(unit);
+			}
+		}
+	}
+
 	surface->lock();
 	const auto cameraPos = _camera->getMapOffset();
 	for (int itZ = beginZ; itZ <= endZ; itZ++)
@@ -1817,6 +1849,7 @@ void Map::drawTerrain(Surface *surface)
 	}
 
 	surface->unlock();
+	_tileShadeFrame = 0;
 }
 
 /**
@@ -1904,10 +1937,32 @@ void Map::persistToggles()
 
 /**
  * Handles fade-in and fade-out shade modification
+ * During drawing, shade of every tile is calculated only once per frame.
  * @param original tile/item/unit shade
  */
 
 int Map::reShade(Tile *tile)
+{
+	if (_tileShadeFrame == 0)
+	{
+		return calculateShade(tile, *_save->getUnits());
+	}
+	int index = _save->getTileIndex(tile->getPosition());
+	if (_tileShadeFrames[index] != _tileShadeFrame)
+	{
+		_tileShades[index] = calculateShade(tile, _nightVisionUnits);
+		_tileShadeFrames[index] = _tileShadeFrame;
+	}
+	return _tileShades[index];
+}
+
+/**
+ * Calculates shade of tile, with night vision and debug vision applied.
+ * @param tile Tile to check.
+ * @param units Units that can light up tiles around them with night vision.
+ * @return Shade of tile.
+ */
+int Map::calculateShade(Tile *tile, const std::vector<BattleUnit*> &units)
 {
 	// when modders just don't know where to stop...
 	if (_debugVisionMode > 0)
@@ -1934,7 +1989,7 @@ int Map::reShade(Tile *tile)
 	}
 
 	// hybrid night vision (local)
-	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	for (std::vector<BattleUnit*>::const_iterator i = units.begin(); i != units.end(); ++i)
 	{
 		if ((*i)->getFaction() == FACTION_PLAYER && !(*i)->isOut())
 		{
@@ -2017,7 +2072,11 @@ void Map::animate(bool redraw)
 	// animate tiles
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
-		_save->getTile(i)->animate();
+		if (_save->getTile(i)->animate())
+		{
+			// opening ufo door can change move cost
+			_save->getPathfinding()->invalidateTUCostCache(_save->getTileCoords(i));
+		}
 	}
 
 	// init vapor vector
@@ -110,6 +110,16 @@ private:
 	int _iconHeight, _iconWidth, _messageColor;
 	const std::vector<Uint8> *_transparencies;
 	bool _showObstacles;
+	/// Shades of tiles calculated during current drawTerrain call.
+	std::vector<Uint8> _tileShades;
+	/// Number of drawTerrain call in which shade of tile was calculated.
+	std::vector<Uint32> _tileShadeFrames;
+	/// Number of current drawTerrain call, 0 outside of it.
+	Uint32 _tileShadeFrame, _lastTileShadeFrame;
+	/// Player units that can give local night vision during current drawTerrain call.
+	std::vector<BattleUnit*> _nightVisionUnits;
+	/// Calculates shade of tile with fading.
+	int calculateShade(Tile *tile, const std::vector<BattleUnit*> &units);
 public:
 	/// Creates a new map at the specified position and size.
 	Map(Game* game, int width, int height, int x, int y, int visibleMapHeight);
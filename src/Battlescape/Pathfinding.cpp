@@ -43,7 +43,7 @@ int Pathfinding::green = 4;
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false)
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false), _hierarchy(save, this)
 {
 	_size = _save->getMapSizeXYZ();
 	// Initialize one node per tile
@@ -160,6 +160,16 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
 	{
 		abortPath(); // if bresenham failed, we shouldn't keep the path it was attempting, in case A* fails too.
 	}
+	// For long paths first try A* limited to clusters along the path found on the abstract graph.
+	if (Options::oxcePathfindingHierarchy && bam != BAM_MISSILE && _hierarchy.isLongPath(startPosition, endPosition))
+	{
+		std::vector<bool> corridor;
+		if (_hierarchy.findCorridor(_unit, bam, startPosition, endPosition, corridor) &&
+			aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost, &corridor))
+		{
+			return;
+		}
+	}
 	// Now try through A*.
 	if (!aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost))
 	{
@@ -176,9 +186,29 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
  * @param missileTarget Target of the path.
  * @param sneak Is the unit sneaking?
  * @param maxTUCost Maximum time units the path can cost.
+ * @param corridor Optional clusters of PathfindingHierarchy that the path can use.
  * @return True if a path exists, false otherwise.
  */
-bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost)
+bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost, const std::vector<bool> *corridor)
+{
+	if (Options::oxcePathfindingBucketQueue)
+	{
+		_bucketOpenSet.clear();
+		return aStarPathImpl(_bucketOpenSet, startPosition, endPosition, bam, missileTarget, sneak, maxTUCost, corridor);
+	}
+	else
+	{
+		PathfindingOpenSet openList;
+		return aStarPathImpl(openList, startPosition, endPosition, bam, missileTarget, sneak, maxTUCost, corridor);
+	}
+}
+
+/**
+ * A-Star algorithm implementation, shared by all types of open set.
+ * @param openList Empty open set used by search.
+ */
+template<typename OpenSet>
+bool Pathfinding::aStarPathImpl(OpenSet &openList, Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost, const std::vector<bool> *corridor)
 {
 	// reset every node, so we have to check them all
 	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
@@ -187,7 +217,6 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 	// start position is the first one in our "open" list
 	PathfindingNode *start = getNode(startPosition);
 	start->connect({}, 0, 0, endPosition);
-	PathfindingOpenSet openList;
 	openList.push(start);
 	bool missile = (bam == BAM_MISSILE);
 	// if the open list is empty, we've reached the end
@@ -216,6 +245,8 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 				continue;
 
 			Position nextPos = r.pos;
+			if (corridor && !_hierarchy.isInCorridor(*corridor, nextPos)) // Stay in clusters selected by hierarchy.
+				continue;
 			if (sneak && _save->getTile(nextPos)->getVisible()) r.cost.time *= 2; // avoid being seen
 			PathfindingNode *nextNode = getNode(nextPos);
 			if (nextNode->isChecked()) // Our algorithm means this node is already at minimum cost.
@@ -237,6 +268,8 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
  * Gets the TU cost to move from 1 tile to the other (ONE STEP ONLY).
  * But also updates the endPosition, because it is possible
  * the unit goes upstairs or falls down while walking.
+ * Terrain part of the cost is taken from the edge cache when possible,
+ * units, fire and smoke are always checked.
  * @param startPosition The position to start from.
  * @param direction The direction we are facing.
  * @param endPosition The position we want to reach.
@@ -247,6 +280,63 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
  */
 PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
 {
+	return getTUCostFinal(getTerrainEdge(startPosition, direction, unit, missileTarget, bam), startPosition, direction, unit, missileTarget, bam);
+}
+
+/**
+ * Gets the terrain part of the step cost, from the edge cache when possible.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param unit The unit moving.
+ * @param missileTarget The target unit used for BAM_MISSILE.
+ * @param bam What move type is required (one special case is BAM_MISSILE)?
+ * @return Terrain cost of the step.
+ */
+PathfindingEdge Pathfinding::getTerrainEdge(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
+{
+	if (bam != BAM_MISSILE && Options::oxcePathfindingEdgeCache)
+	{
+		if (!_save->getTile(startPosition))
+		{
+			return { { }, PathfindingEdge::EDGE_INVALID };
+		}
+
+		const auto movementType = getMovementType(unit, missileTarget, bam);
+		const int variant = (movementType * 2 + (unit->getMovementType() == MT_FLY ? 1 : 0)) * 2 + (unit->getArmor()->getSize() - 1);
+		auto &cache = _edgeCache[variant];
+		if (cache.empty())
+		{
+			cache.resize(_size * dir_max);
+		}
+
+		auto &edge = cache[_save->getTileIndex(startPosition) * dir_max + direction];
+		if (edge.state == PathfindingEdge::EDGE_UNKNOWN)
+		{
+			edge = getTUCostTerrain(startPosition, direction, unit, missileTarget, bam);
+		}
+		return edge;
+	}
+	else
+	{
+		return getTUCostTerrain(startPosition, direction, unit, missileTarget, bam);
+	}
+}
+
+/**
+ * Gets the part of the step cost that depends only on terrain.
+ * Nothing that can change without terrain change (units, fire, smoke, unit stats) can be used here,
+ * because result of this function is stored in the edge cache.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param unit The unit moving.
+ * @param missileTarget The target unit used for BAM_MISSILE.
+ * @param bam What move type is required (one special case is BAM_MISSILE)?
+ * @return Terrain cost of the step.
+ */
+PathfindingEdge Pathfinding::getTUCostTerrain(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
+{
+	const PathfindingEdge invalid = { { }, PathfindingEdge::EDGE_INVALID };
+
 	Position pos;
 	directionToVector(direction, &pos);
 	pos += startPosition;
@@ -261,6 +351,8 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	int maskOfPartsFalling = 0x0;
 	int maskOfPartsFlying = 0x0;
 	int maskOfPartsGround = 0x0;
+	int maskOfPartsOverlapping = 0x0;
+	int maskOfPartsFloorBlocked = 0x0;
 	int maskArmor = size ? 0xF : 0x1;
 
 	Position offsets[4] =
@@ -282,7 +374,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		Tile* dt = _save->getTile(pos + offsets[i]);
 		if (!st || !dt)
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		}
 		startTile[i] = st;
 		destinationTile[i] = dt;
@@ -298,9 +390,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// check if we can go this way
 			if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-				return {{INVALID_MOVE_COST, 0}};
+				return invalid;
 			if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-				return {{INVALID_MOVE_COST, 0}};
+				return invalid;
 		}
 
 		// if we are on a stairs try to go up a level
@@ -314,12 +406,8 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		}
 		else if (bam != BAM_MISSILE && movementType == MT_FLY)
 		{
-			// 2 or more voxels poking into this tile = no go
-			auto overlaping = destinationTile[i]->getOverlappingUnit(_save, TUO_IGNORE_SMALL);
-			if (overlaping && overlaping != unit)
-			{
-				return {{INVALID_MOVE_COST, 0}};
-			}
+			// units poking into this tile are checked later
+			maskOfPartsOverlapping |= maskCurrentPart;
 		}
 
 		auto aboveStart =_save->getAboveTile(startTile[i]);
@@ -351,7 +439,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	{
 		if (direction != DIR_DOWN)
 		{
-			return {{INVALID_MOVE_COST, 0}}; //cannot walk on air
+			return invalid; //cannot walk on air
 		}
 	}
 
@@ -366,10 +454,14 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 			destinationTile[i] = belowDestination[i];
 		}
 
-		// check if the destination tile can be walked over
-		if (isBlocked(unit, destinationTile[i], O_FLOOR, bam, missileTarget) || isBlocked(unit, destinationTile[i], O_OBJECT, bam, missileTarget))
+		// check if the destination tile can be walked over, units standing there are checked later
+		if (isBlockedByTerrain(unit, destinationTile[i], O_FLOOR, bam, missileTarget))
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			maskOfPartsFloorBlocked |= 1 << i;
+		}
+		if (isBlocked(unit, destinationTile[i], O_OBJECT, bam, missileTarget))
+		{
+			return invalid;
 		}
 	}
 
@@ -380,27 +472,12 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		if ((t->isDoor(O_NORTHWALL)) ||
 			(t->isDoor(O_WESTWALL)))
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		}
 	}
 
-	// pre-calculate fire penalty (to make it consistent for 2x2 units)
-	auto firePenaltyCost = 0;
-	if (unit->getFaction() != FACTION_PLAYER &&
-		unit->getSpecialAbility() < SPECAB_BURNFLOOR)
-	{
-		for (int i = 0; i < numberOfParts; ++i)
-		{
-			if (destinationTile[i]->getFire() > 0)
-			{
-				firePenaltyCost = FIRE_PREVIEW_MOVE_COST; // try to find a better path, but don't exclude this path entirely.
-			}
-		}
-	}
-
-
 	// calculate cost and some final checks
-	auto totalCost = 0;
+	PathfindingEdge edge = { { }, PathfindingEdge::EDGE_VALID };
 
 	for (int i = 0; i < numberOfParts; ++i)
 	{
@@ -411,9 +488,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// check if we can go this way
 			if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-				return {{INVALID_MOVE_COST, 0}};
+				return invalid;
 			if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-				return {{INVALID_MOVE_COST, 0}};
+				return invalid;
 		}
 		else if (direction >= DIR_UP && !triedStairsDown)
 		{
@@ -424,7 +501,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 			}
 			else
 			{
-				return {{INVALID_MOVE_COST, 0}};
+				return invalid;
 			}
 		}
 		if (upperLevel)
@@ -435,9 +512,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 			{
 				// check if we can go this way
 				if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-					return {{INVALID_MOVE_COST, 0}};
+					return invalid;
 				if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-					return {{INVALID_MOVE_COST, 0}};
+					return invalid;
 			}
 		}
 
@@ -456,7 +533,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		// for backward compatiblity (100 + 100 + 100 > 255) or for (255 + 10 > 255)
 		if (wallcost >= INVALID_MOVE_COST)
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		}
 
 		// if we don't want to fall down and there is no floor, we can't know the TUs so it's default to 4
@@ -494,56 +571,159 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 
 		cost += wallcost;
 
-		// TFTD thing: underwater tiles on fire or filled with smoke cost 2 TUs more for whatever reason.
-		if (_save->getDepth() > 0 && (destinationTile[i]->getFire() > 0 || destinationTile[i]->getSmoke() > 0))
-		{
-			cost += 2;
-		}
-
-		// Strafing costs +1 for forwards-ish or sidewards, propose +2 for backwards-ish directions
-		// Maybe if flying then it makes no difference?
-		if (_strafeMove && bam == BAM_STRAFE)
-		{
-			if (unit->getDirection() != direction)
-			{
-				cost += 1;
-			}
-		}
-
-		// cap move cost to given limit
-		cost = std::min(cost, +MAX_MOVE_COST);
-
-		totalCost += cost;
+		// final cap is applied after fire, smoke and strafing are added, capping it here too does not change final result
+		edge.partCost[i] = std::min(cost, +MAX_MOVE_COST);
 	}
 
 	// because unit move up or down we adjust final position
 	if (triedStairs)
 	{
 		pos.z++;
+		edge.levelChange = +1;
 	}
 	else if (direction != DIR_DOWN && triedStairsDown)
 	{
 		pos.z--;
+		edge.levelChange = -1;
 	}
 
 	// for bigger sized units, check the path between parts in an X shape at the end position
 	if (size)
 	{
-		totalCost /= numberOfParts;
 		Tile *originTile = _save->getTile(pos + Position(1,1,0));
 		Tile *finalTile = _save->getTile(pos);
 		int tmpDirection = 7;
 		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		originTile = _save->getTile(pos + Position(1,0,0));
 		finalTile = _save->getTile(pos + Position(0,1,0));
 		tmpDirection = 5;
 		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
-			return {{INVALID_MOVE_COST, 0}};
+			return invalid;
 		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
+			return invalid;
+	}
+
+	edge.floorBlockedMask = maskOfPartsFloorBlocked;
+	edge.overlappingMask = maskOfPartsOverlapping;
+	edge.fallingDown = fallingDown;
+	edge.flying = flying;
+	return edge;
+}
+
+/**
+ * Gets the final cost of the step, applying units, fire, smoke and unit move costs on top of the terrain cost.
+ * @param edge Terrain cost of the step.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param unit The unit moving.
+ * @param missileTarget The target unit used for BAM_MISSILE.
+ * @param bam What move type is required (one special case is BAM_MISSILE)?
+ * @return TU cost or 255 if movement is impossible.
+ */
+PathfindingStep Pathfinding::getTUCostFinal(const PathfindingEdge &edge, Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
+{
+	if (edge.state != PathfindingEdge::EDGE_VALID)
+	{
+		return {{INVALID_MOVE_COST, 0}};
+	}
+
+	Position pos;
+	directionToVector(direction, &pos);
+	pos += startPosition;
+
+	const Armor* armor =  unit->getArmor();
+	const int size = armor->getSize() - 1;
+	const int numberOfParts = armor->getTotalSize();
+
+	Position offsets[4] =
+	{
+		{ 0, 0, 0 },
+		{ 1, 0, 0 },
+		{ 0, 1, 0 },
+		{ 1, 1, 0 },
+	};
+	Tile* destinationTile[4] = { };
+
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		if (edge.overlappingMask & (1 << i))
+		{
+			// 2 or more voxels poking into this tile = no go
+			auto overlaping = _save->getTile(pos + offsets[i])->getOverlappingUnit(_save, TUO_IGNORE_SMALL);
+			if (overlaping && overlaping != unit)
+			{
+				return {{INVALID_MOVE_COST, 0}};
+			}
+		}
+	}
+
+	// because unit move up or down we adjust final position
+	pos.z += edge.levelChange;
+
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		destinationTile[i] = _save->getTile(pos + offsets[i]);
+
+		// check if the destination tile can be walked over
+		auto blockedByUnit = isBlockedByUnit(unit, destinationTile[i], bam, missileTarget);
+		if (blockedByUnit == UNIT_BLOCKED ||
+			(blockedByUnit == UNIT_UNDECIDED && (edge.floorBlockedMask & (1 << i))))
+		{
 			return {{INVALID_MOVE_COST, 0}};
+		}
+	}
+
+	// pre-calculate fire penalty (to make it consistent for 2x2 units)
+	auto firePenaltyCost = 0;
+	if (unit->getFaction() != FACTION_PLAYER &&
+		unit->getSpecialAbility() < SPECAB_BURNFLOOR)
+	{
+		for (int i = 0; i < numberOfParts; ++i)
+		{
+			if (destinationTile[i]->getFire() > 0)
+			{
+				firePenaltyCost = FIRE_PREVIEW_MOVE_COST; // try to find a better path, but don't exclude this path entirely.
+			}
+		}
+	}
+
+
+	// calculate cost
+	auto totalCost = 0;
+
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		int cost = edge.partCost[i];
+
+		// TFTD thing: underwater tiles on fire or filled with smoke cost 2 TUs more for whatever reason.
+		if (_save->getDepth() > 0 && (destinationTile[i]->getFire() > 0 || destinationTile[i]->getSmoke() > 0))
+		{
+			cost += 2;
+		}
+
+		// Strafing costs +1 for forwards-ish or sidewards, propose +2 for backwards-ish directions
+		// Maybe if flying then it makes no difference?
+		if (_strafeMove && bam == BAM_STRAFE)
+		{
+			if (unit->getDirection() != direction)
+			{
+				cost += 1;
+			}
+		}
+
+		// cap move cost to given limit
+		cost = std::min(cost, +MAX_MOVE_COST);
+
+		totalCost += cost;
+	}
+
+	// for bigger sized units, average cost of all parts
+	if (size)
+	{
+		totalCost /= numberOfParts;
 	}
 
 
@@ -552,11 +732,12 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		return { { }, { }, pos };
 	}
 
-	if (direction == DIR_DOWN && fallingDown)
+	if (direction == DIR_DOWN && edge.fallingDown)
 	{
 		return { { }, { firePenaltyCost, 0 }, pos };
 	}
 
+	const bool flying = edge.flying;
 	const auto costDiv = 100 * 100 * 100;
 	ArmorMoveCost cost = { totalCost, totalCost };
 
@@ -670,6 +851,41 @@ void Pathfinding::abortPath()
 	_path.clear();
 }
 
+/**
+ * Forgets cached TU costs of all steps that could depend on a tile at given position.
+ * Needs to be called after any change of terrain (destroyed parts, doors, etc.), units are not cached.
+ * @param pos Position of changed tile.
+ */
+void Pathfinding::invalidateTUCostCache(Position pos)
+{
+	// 2x2 units and diagonal wall checks look up to 3 tiles away from the start, stairs and falling one level up or down.
+	constexpr int rangeXY = 3;
+	constexpr int rangeZ = 1;
+
+	for (auto &cache : _edgeCache)
+	{
+		if (cache.empty())
+		{
+			continue;
+		}
+		for (int z = std::max(pos.z - rangeZ, 0); z <= std::min(pos.z + rangeZ, _save->getMapSizeZ() - 1); ++z)
+		{
+			for (int y = std::max(pos.y - rangeXY, 0); y <= std::min(pos.y + rangeXY, _save->getMapSizeY() - 1); ++y)
+			{
+				for (int x = std::max(pos.x - rangeXY, 0); x <= std::min(pos.x + rangeXY, _save->getMapSizeX() - 1); ++x)
+				{
+					const int index = _save->getTileIndex(Position(x, y, z)) * dir_max;
+					for (int direction = 0; direction < dir_max; ++direction)
+					{
+						cache[index + direction].state = PathfindingEdge::EDGE_UNKNOWN;
+					}
+				}
+			}
+		}
+	}
+	_hierarchy.invalidate(pos);
+}
+
 /**
  * Gets movement type of unit or movement of missile.
  * @param unit Unit we check path for.
@@ -706,6 +922,28 @@ bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int
 {
 	if (tile == 0) return true; // probably outside the map here
 
+	if (part == O_FLOOR)
+	{
+		auto blockedByUnit = isBlockedByUnit(unit, tile, bam, missileTarget);
+		if (blockedByUnit != UNIT_UNDECIDED)
+		{
+			return blockedByUnit == UNIT_BLOCKED;
+		}
+	}
+	return isBlockedByTerrain(unit, tile, part, bam, missileTarget, bigWallExclusion);
+}
+
+/**
+ * Determines whether a certain part of a tile blocks movement, ignoring any units.
+ * @param tile Specified tile, can be a null pointer.
+ * @param part Part of the tile.
+ * @param missileTarget Target for a missile.
+ * @return True if the movement is blocked.
+ */
+bool Pathfinding::isBlockedByTerrain(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion) const
+{
+	if (tile == 0) return true; // probably outside the map here
+
 	auto movementType = getMovementType(unit, missileTarget, bam);
 
 	if (part == O_BIGWALL)
@@ -744,63 +982,75 @@ bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int
 			tileNorth->getMapData(O_OBJECT)->getBigWall() == BIGWALLEASTANDSOUTH))
 			return true; // blocking part
 	}
-	if (part == O_FLOOR)
+	// missiles can't pathfind through closed doors.
+	{ TilePart tp = (TilePart)part;
+	if (missileTarget != 0 && tile->getMapData(tp) &&
+		(tile->isDoor(tp) ||
+		(tile->isUfoDoor(tp) &&
+		!tile->isUfoDoorOpen(tp))))
 	{
-		if (tile->getUnit())
+		return true;
+	}}
+	if (tile->getTUCost(part, movementType) == Pathfinding::INVALID_MOVE_COST) return true; // blocking part
+	return false;
+}
+
+/**
+ * Determines whether units on or below a tile block moving onto its floor.
+ * @param unit Unit that move.
+ * @param tile Specified tile.
+ * @param bam Move type.
+ * @param missileTarget Target for a missile.
+ * @return Blocked or not blocked, or undecided when terrain should decide.
+ */
+Pathfinding::UnitBlockage Pathfinding::isBlockedByUnit(const BattleUnit *unit, const Tile *tile, BattleActionMove bam, const BattleUnit *missileTarget) const
+{
+	auto movementType = getMovementType(unit, missileTarget, bam);
+
+	if (tile->getUnit())
+	{
+		BattleUnit *u = tile->getUnit();
+		if (u == unit || u == missileTarget || u->isOut()) return UNIT_NOT_BLOCKED;
+		if (missileTarget && u != missileTarget && u->getFaction() == FACTION_HOSTILE)
+			return UNIT_BLOCKED;			// AI pathfinding with missiles shouldn't path through their own units
+		if (unit)
 		{
-			BattleUnit *u = tile->getUnit();
-			if (u == unit || u == missileTarget || u->isOut()) return false;
-			if (missileTarget && u != missileTarget && u->getFaction() == FACTION_HOSTILE)
-				return true;			// AI pathfinding with missiles shouldn't path through their own units
-			if (unit)
-			{
-				if (unit->getFaction() == FACTION_PLAYER && u->getVisible()) return true;		// player know all visible units
-				if (unit->getFaction() == u->getFaction()) return true;
-				if (unit->getFaction() == FACTION_HOSTILE &&
-					std::find(unit->getUnitsSpottedThisTurn().begin(), unit->getUnitsSpottedThisTurn().end(), u) != unit->getUnitsSpottedThisTurn().end()) return true;
-			}
+			if (unit->getFaction() == FACTION_PLAYER && u->getVisible()) return UNIT_BLOCKED;		// player know all visible units
+			if (unit->getFaction() == u->getFaction()) return UNIT_BLOCKED;
+			if (unit->getFaction() == FACTION_HOSTILE &&
+				std::find(unit->getUnitsSpottedThisTurn().begin(), unit->getUnitsSpottedThisTurn().end(), u) != unit->getUnitsSpottedThisTurn().end()) return UNIT_BLOCKED;
 		}
-		else if (tile->hasNoFloor(0) && movementType != MT_FLY) // this whole section is devoted to making large units not take part in any kind of falling behaviour
+	}
+	else if (tile->hasNoFloor(0) && movementType != MT_FLY) // this whole section is devoted to making large units not take part in any kind of falling behaviour
+	{
+		Position pos = tile->getPosition();
+		while (pos.z >= 0)
 		{
-			Position pos = tile->getPosition();
-			while (pos.z >= 0)
-			{
-				Tile *t = _save->getTile(pos);
-				BattleUnit *u = t->getUnit();
+			Tile *t = _save->getTile(pos);
+			BattleUnit *u = t->getUnit();
 
-				if (u != 0 && u != unit)
+			if (u != 0 && u != unit)
+			{
+				// don't let large units fall on other units
+				if (unit && unit->isBigUnit())
 				{
-					// don't let large units fall on other units
-					if (unit && unit->isBigUnit())
-					{
-						return true;
-					}
-					// don't let any units fall on large units
-					if (u != unit && u != missileTarget && !u->isOut() && u->isBigUnit())
-					{
-						return true;
-					}
+					return UNIT_BLOCKED;
 				}
-				// not gonna fall any further, so we can stop checking.
-				if (!t->hasNoFloor(0))
+				// don't let any units fall on large units
+				if (u != unit && u != missileTarget && !u->isOut() && u->isBigUnit())
 				{
-					break;
+					return UNIT_BLOCKED;
 				}
-				pos.z--;
 			}
+			// not gonna fall any further, so we can stop checking.
+			if (!t->hasNoFloor(0))
+			{
+				break;
+			}
+			pos.z--;
 		}
 	}
-	// missiles can't pathfind through closed doors.
-	{ TilePart tp = (TilePart)part;
-	if (missileTarget != 0 && tile->getMapData(tp) &&
-		(tile->isDoor(tp) ||
-		(tile->isUfoDoor(tp) &&
-		!tile->isUfoDoorOpen(tp))))
-	{
-		return true;
-	}}
-	if (tile->getTUCost(part, movementType) == Pathfinding::INVALID_MOVE_COST) return true; // blocking part
-	return false;
+	return UNIT_UNDECIDED;
 }
 
 /**
@@ -1320,6 +1570,25 @@ bool Pathfinding::bresenhamPath(Position origin, Position target, BattleActionMo
  * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
  */
 std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const BattleActionCost &cost)
+{
+	if (Options::oxcePathfindingBucketQueue)
+	{
+		_bucketOpenSet.clear();
+		return findReachableImpl(_bucketOpenSet, unit, cost);
+	}
+	else
+	{
+		PathfindingOpenSet unvisited;
+		return findReachableImpl(unvisited, unit, cost);
+	}
+}
+
+/**
+ * Dijkstra's algorithm implementation, shared by all types of open set.
+ * @param unvisited Empty open set used by search.
+ */
+template<typename OpenSet>
+std::vector<int> Pathfinding::findReachableImpl(OpenSet &unvisited, const BattleUnit *unit, const BattleActionCost &cost)
 {
 	const Position start = unit->getPosition();
 	int tuMax = unit->getTimeUnits() - cost.Time;
@@ -1333,7 +1602,6 @@ std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const Battle
 	}
 	PathfindingNode *startNode = getNode(start);
 	startNode->connect({}, 0, 0);
-	PathfindingOpenSet unvisited;
 	unvisited.push(startNode);
 	std::vector<PathfindingNode*> reachable;
 	while (!unvisited.empty())
@@ -20,6 +20,8 @@
 #include <vector>
 #include "Position.h"
 #include "PathfindingNode.h"
+#include "PathfindingOpenSet.h"
+#include "PathfindingHierarchy.h"
 #include "../Mod/MapData.h"
 
 namespace OpenXcom
@@ -53,6 +55,16 @@ private:
 	bool _ctrlUsed = false;
 	bool _altUsed = false;
 	PathfindingCost _totalTUCost;
+	/// Open set reused between searches when bucket queue is enabled.
+	PathfindingBucketOpenSet _bucketOpenSet;
+	/// Cached terrain cost of each step, one table per movement type, flying ability and unit size.
+	mutable std::vector<PathfindingEdge> _edgeCache[5 * 2 * 2];
+	/// Abstract graph used for long paths.
+	PathfindingHierarchy _hierarchy;
+	friend class PathfindingHierarchy;
+
+	/// Result of checking units that block a tile.
+	enum UnitBlockage { UNIT_UNDECIDED, UNIT_BLOCKED, UNIT_NOT_BLOCKED };
 
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(Position pos);
@@ -61,12 +73,28 @@ private:
 	MovementType getMovementType(const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
 	/// Determines whether a tile blocks a certain movementType.
 	bool isBlocked(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion = -1) const;
+	/// Determines whether a tile blocks a certain movementType, ignoring units.
+	bool isBlockedByTerrain(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion = -1) const;
+	/// Determines whether units block moving onto a tile.
+	UnitBlockage isBlockedByUnit(const BattleUnit *unit, const Tile *tile, BattleActionMove bam, const BattleUnit *missileTarget) const;
+	/// Gets the terrain part of the TU cost to move from 1 tile to the other, using cache.
+	PathfindingEdge getTerrainEdge(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
+	/// Gets the terrain part of the TU cost to move from 1 tile to the other.
+	PathfindingEdge getTUCostTerrain(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
+	/// Gets the final TU cost to move from 1 tile to the other.
+	PathfindingStep getTUCostFinal(const PathfindingEdge &edge, Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
 	/// Determines whether or not movement between start tile and end tile is possible in the direction.
 	bool isBlockedDirection(const BattleUnit *unit, Tile *startTile, const int direction, BattleActionMove bam, const BattleUnit *missileTarget) const;
 	/// Tries to find a straight line path between two positions.
 	bool bresenhamPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
 	/// Tries to find a path between two positions.
-	bool aStarPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
+	bool aStarPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000, const std::vector<bool> *corridor = nullptr);
+	/// Tries to find a path between two positions using given open set.
+	template<typename OpenSet>
+	bool aStarPathImpl(OpenSet &openList, Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost, const std::vector<bool> *corridor);
+	/// Gets all reachable tiles using given open set.
+	template<typename OpenSet>
+	std::vector<int> findReachableImpl(OpenSet &unvisited, const BattleUnit *unit, const BattleActionCost &cost);
 	/// Determines whether a unit can fall down from this tile.
 	bool canFallDown(Tile *destinationTile) const;
 	/// Determines whether a unit can fall down from this tile.
@@ -149,6 +177,8 @@ public:
 	PathfindingStep getTUCost(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
 	/// Aborts the current path.
 	void abortPath();
+	/// Forgets cached TU costs of steps affected by a terrain change at given position.
+	void invalidateTUCostCache(Position pos);
 	/// Gets the strafe move setting.
 	bool getStrafeMove() const;
 	/// Checks, for the up/down button, if the movement is valid.
@@ -0,0 +1,500 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include "PathfindingHierarchy.h"
+#include "Pathfinding.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Mod/Armor.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up the hierarchy, nothing is built until first search.
+ * @param save Pointer to SavedBattleGame object.
+ * @param pathfinding Pathfinding used to get terrain costs.
+ */
+PathfindingHierarchy::PathfindingHierarchy(SavedBattleGame *save, const Pathfinding *pathfinding) : _save(save), _pathfinding(pathfinding)
+{
+	_clustersX = (_save->getMapSizeX() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	_clustersY = (_save->getMapSizeY() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+}
+
+/**
+ * Deletes the hierarchy.
+ */
+PathfindingHierarchy::~PathfindingHierarchy()
+{
+
+}
+
+/**
+ * Gets index of movement kind, abstract graph is separate for each one.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ * @return Index of graph.
+ */
+int PathfindingHierarchy::getVariant(const BattleUnit *unit, BattleActionMove bam) const
+{
+	const MovementType movementType = _pathfinding->getMovementType(unit, nullptr, bam);
+	return (movementType * 2 + (unit->getMovementType() == MT_FLY ? 1 : 0)) * 2 + (unit->getArmor()->getSize() - 1);
+}
+
+/**
+ * Gets cost of one step using only terrain, units, fire and unit move costs are ignored.
+ * @param pos Start position.
+ * @param direction Direction of the step.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ * @param result Final position of the step.
+ * @return Approximate cost of the step or -1 if terrain blocks it.
+ */
+int PathfindingHierarchy::getTerrainCost(Position pos, int direction, const BattleUnit *unit, BattleActionMove bam, Position &result) const
+{
+	const PathfindingEdge edge = _pathfinding->getTerrainEdge(pos, direction, unit, nullptr, bam);
+	if (edge.state != PathfindingEdge::EDGE_VALID)
+	{
+		return -1;
+	}
+
+	Pathfinding::directionToVector(direction, &result);
+	result += pos;
+	result.z += edge.levelChange;
+
+	const int numberOfParts = unit->getArmor()->getTotalSize();
+	int cost = 0;
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		cost += edge.partCost[i];
+	}
+	return std::max(cost / numberOfParts, 1);
+}
+
+/**
+ * Gets position of given abstract node.
+ * @param graph Graph of the node.
+ * @param node Node id.
+ * @return Position of tile.
+ */
+Position PathfindingHierarchy::getNodePosition(const Graph &graph, int node) const
+{
+	const int border = node / 2 / MAX_ENTRANCES;
+	const int entrance = (node / 2) % MAX_ENTRANCES;
+	return graph.borders[border].entrances[entrance].pos[node & 1];
+}
+
+/**
+ * Gets cluster of given abstract node.
+ * Node with side 0 is in cluster that owns the border, side 1 is in its east or south neighbour.
+ * @param node Node id.
+ * @return Index of cluster.
+ */
+int PathfindingHierarchy::getNodeCluster(int node) const
+{
+	const int border = node / 2 / MAX_ENTRANCES;
+	const int cluster = border / 2;
+	if ((node & 1) == 0)
+	{
+		return cluster;
+	}
+	return (border % 2 == 0) ? cluster + 1 : cluster + _clustersX;
+}
+
+/**
+ * Gets index of tile in tables local to cluster.
+ * @param cluster Index of cluster.
+ * @param pos Position in that cluster.
+ * @return Local index.
+ */
+int PathfindingHierarchy::getClusterTileIndex(int cluster, Position pos) const
+{
+	const int x = pos.x - (cluster % _clustersX) * CLUSTER_SIZE;
+	const int y = pos.y - (cluster / _clustersX) * CLUSTER_SIZE;
+	return (pos.z * CLUSTER_SIZE + y) * CLUSTER_SIZE + x;
+}
+
+/**
+ * Finds entrances on border between cluster and its east or south neighbour.
+ * Every continuous line of tiles that can be crossed in both directions is one entrance placed in its middle.
+ * @param graph Graph to update.
+ * @param border Index of border.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ */
+void PathfindingHierarchy::buildBorder(Graph &graph, int border, const BattleUnit *unit, BattleActionMove bam)
+{
+	Border &data = graph.borders[border];
+	data.entrances.clear();
+	data.dirty = false;
+
+	const int cluster = border / 2;
+	const bool east = (border % 2 == 0);
+	const int cx = cluster % _clustersX;
+	const int cy = cluster / _clustersX;
+	if ((east && cx + 1 >= _clustersX) || (!east && cy + 1 >= _clustersY))
+	{
+		return;
+	}
+
+	const Position step = east ? Position(1, 0, 0) : Position(0, 1, 0);
+	const int dirForward = east ? 2 : 4;
+	const int dirBackward = east ? 6 : 0;
+
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+	{
+		Entrance line[CLUSTER_SIZE];
+		int segmentStart = -1;
+		for (int i = 0; i <= CLUSTER_SIZE; ++i)
+		{
+			bool valid = false;
+			if (i < CLUSTER_SIZE)
+			{
+				Entrance &e = line[i];
+				e.pos[0] = east ? Position(cx * CLUSTER_SIZE + CLUSTER_SIZE - 1, cy * CLUSTER_SIZE + i, z) : Position(cx * CLUSTER_SIZE + i, cy * CLUSTER_SIZE + CLUSTER_SIZE - 1, z);
+				e.pos[1] = e.pos[0] + step;
+				if (_save->getTile(e.pos[1]))
+				{
+					Position result;
+					e.cost[0] = getTerrainCost(e.pos[0], dirForward, unit, bam, result);
+					valid = e.cost[0] >= 0 && result == e.pos[1];
+					if (valid)
+					{
+						e.cost[1] = getTerrainCost(e.pos[1], dirBackward, unit, bam, result);
+						valid = e.cost[1] >= 0 && result == e.pos[0];
+					}
+				}
+			}
+
+			if (valid && segmentStart < 0)
+			{
+				segmentStart = i;
+			}
+			else if (!valid && segmentStart >= 0)
+			{
+				if ((int)data.entrances.size() < MAX_ENTRANCES)
+				{
+					data.entrances.push_back(line[(segmentStart + i - 1) / 2]);
+				}
+				segmentStart = -1;
+			}
+		}
+	}
+}
+
+/**
+ * Gets cluster data, rebuilding its borders and distances between entrances if needed.
+ * @param graph Graph of the cluster.
+ * @param cluster Index of cluster.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ * @return Up to date cluster data.
+ */
+PathfindingHierarchy::Cluster &PathfindingHierarchy::getClusterData(Graph &graph, int cluster, const BattleUnit *unit, BattleActionMove bam)
+{
+	Cluster &data = graph.clusters[cluster];
+	if (!data.dirty)
+	{
+		return data;
+	}
+
+	const int cx = cluster % _clustersX;
+	const int cy = cluster / _clustersX;
+
+	// own east and south borders have nodes on side 0, west and north borders of neighbours on side 1
+	int borders[4][2] = { { cluster * 2 + 0, 0 }, { cluster * 2 + 1, 0 }, { -1, 1 }, { -1, 1 } };
+	if (cx > 0)
+	{
+		borders[2][0] = (cluster - 1) * 2 + 0;
+	}
+	if (cy > 0)
+	{
+		borders[3][0] = (cluster - _clustersX) * 2 + 1;
+	}
+
+	data.nodes.clear();
+	for (auto &b : borders)
+	{
+		if (b[0] < 0)
+		{
+			continue;
+		}
+		if (graph.borders[b[0]].dirty)
+		{
+			buildBorder(graph, b[0], unit, bam);
+		}
+		for (int e = 0; e < (int)graph.borders[b[0]].entrances.size(); ++e)
+		{
+			data.nodes.push_back((b[0] * MAX_ENTRANCES + e) * 2 + b[1]);
+		}
+	}
+
+	const int size = (int)data.nodes.size();
+	data.distances.assign(size * size, -1);
+	std::vector<int> distances;
+	for (int i = 0; i < size; ++i)
+	{
+		getClusterDistances(cluster, getNodePosition(graph, data.nodes[i]), unit, bam, distances);
+		for (int j = 0; j < size; ++j)
+		{
+			data.distances[i * size + j] = distances[getClusterTileIndex(cluster, getNodePosition(graph, data.nodes[j]))];
+		}
+	}
+	data.dirty = false;
+	return data;
+}
+
+/**
+ * Finds terrain distances from one tile to every other tile of its cluster, without leaving the cluster.
+ * @param cluster Index of cluster.
+ * @param from Start position.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ * @param distances Distance for each local tile index, `-1` if not reachable.
+ */
+void PathfindingHierarchy::getClusterDistances(int cluster, Position from, const BattleUnit *unit, BattleActionMove bam, std::vector<int> &distances) const
+{
+	distances.assign(CLUSTER_SIZE * CLUSTER_SIZE * _save->getMapSizeZ(), -1);
+
+	typedef std::pair<int, int> Entry; // cost and local index
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	std::vector<Position> positions(distances.size());
+
+	const int start = getClusterTileIndex(cluster, from);
+	distances[start] = 0;
+	positions[start] = from;
+	open.push(Entry(0, start));
+	while (!open.empty())
+	{
+		const Entry current = open.top();
+		open.pop();
+		if (current.first != distances[current.second])
+		{
+			continue; // already found a better way
+		}
+		const Position pos = positions[current.second];
+		for (int direction = 0; direction < 10; ++direction)
+		{
+			Position next;
+			const int cost = getTerrainCost(pos, direction, unit, bam, next);
+			if (cost < 0 || !_save->getTile(next) || getCluster(next) != cluster)
+			{
+				continue;
+			}
+			const int index = getClusterTileIndex(cluster, next);
+			const int total = current.first + cost;
+			if (distances[index] < 0 || total < distances[index])
+			{
+				distances[index] = total;
+				positions[index] = next;
+				open.push(Entry(total, index));
+			}
+		}
+	}
+}
+
+/**
+ * Checks if start and end are far enough apart that the hierarchy can help.
+ * @param start Start position.
+ * @param end End position.
+ * @return True if there is at least one whole cluster between them.
+ */
+bool PathfindingHierarchy::isLongPath(Position start, Position end) const
+{
+	const int dx = std::abs(start.x / CLUSTER_SIZE - end.x / CLUSTER_SIZE);
+	const int dy = std::abs(start.y / CLUSTER_SIZE - end.y / CLUSTER_SIZE);
+	return std::max(dx, dy) >= 2;
+}
+
+/**
+ * Finds clusters that path between two positions should go through, using only terrain costs.
+ * @param unit Unit that move.
+ * @param bam Move type.
+ * @param start Start position.
+ * @param end End position.
+ * @param corridor For each cluster, whether it is part of the found path.
+ * @return True if abstract path was found.
+ */
+bool PathfindingHierarchy::findCorridor(const BattleUnit *unit, BattleActionMove bam, Position start, Position end, std::vector<bool> &corridor)
+{
+	Graph &graph = _graphs[getVariant(unit, bam)];
+	if (graph.clusters.empty())
+	{
+		graph.clusters.resize(_clustersX * _clustersY);
+		graph.borders.resize(_clustersX * _clustersY * 2);
+	}
+
+	const int startCluster = getCluster(start);
+	const int endCluster = getCluster(end);
+
+	std::vector<int> startDistances, endDistances;
+	getClusterDistances(startCluster, start, unit, bam, startDistances);
+	// costs are nearly symmetric, going from the end is good enough for a corridor
+	getClusterDistances(endCluster, end, unit, bam, endDistances);
+
+	typedef std::pair<int, int> Entry; // estimated total cost and node
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	std::unordered_map<int, int> costs;
+	std::unordered_map<int, int> parents;
+
+	// cheap estimate, as terrain costs are not known in advance
+	auto guess = [&](int node)
+	{
+		return (int)(Position::distance(getNodePosition(graph, node), end) * 2);
+	};
+	auto relax = [&](int node, int cost, int parent)
+	{
+		auto it = costs.find(node);
+		if (it == costs.end() || cost < it->second)
+		{
+			costs[node] = cost;
+			parents[node] = parent;
+			open.push(Entry(cost + guess(node), node));
+		}
+	};
+
+	{
+		Cluster &cluster = getClusterData(graph, startCluster, unit, bam);
+		for (int node : cluster.nodes)
+		{
+			const int distance = startDistances[getClusterTileIndex(startCluster, getNodePosition(graph, node))];
+			if (distance >= 0)
+			{
+				relax(node, distance, -1);
+			}
+		}
+	}
+
+	int bestCost = INT_MAX;
+	int bestNode = -1;
+	while (!open.empty())
+	{
+		const Entry current = open.top();
+		open.pop();
+		if (current.first >= bestCost)
+		{
+			break;
+		}
+		const int node = current.second;
+		const int cost = costs[node];
+		if (current.first != cost + guess(node))
+		{
+			continue; // already found a better way
+		}
+
+		const int clusterIndex = getNodeCluster(node);
+		if (clusterIndex == endCluster)
+		{
+			const int distance = endDistances[getClusterTileIndex(endCluster, getNodePosition(graph, node))];
+			if (distance >= 0 && cost + distance < bestCost)
+			{
+				bestCost = cost + distance;
+				bestNode = node;
+			}
+		}
+
+		// cross the border
+		const auto &entrance = graph.borders[node / 2 / MAX_ENTRANCES].entrances[(node / 2) % MAX_ENTRANCES];
+		relax(node ^ 1, cost + entrance.cost[node & 1], node);
+
+		// move inside the cluster
+		Cluster &cluster = getClusterData(graph, clusterIndex, unit, bam);
+		const int size = (int)cluster.nodes.size();
+		const int i = (int)(std::find(cluster.nodes.begin(), cluster.nodes.end(), node) - cluster.nodes.begin());
+		for (int j = 0; i < size && j < size; ++j)
+		{
+			const int distance = cluster.distances[i * size + j];
+			if (distance > 0)
+			{
+				relax(cluster.nodes[j], cost + distance, node);
+			}
+		}
+	}
+
+	if (bestNode < 0)
+	{
+		return false;
+	}
+
+	corridor.assign(_clustersX * _clustersY, false);
+	corridor[startCluster] = true;
+	corridor[endCluster] = true;
+	for (int node = bestNode; node >= 0; node = parents[node])
+	{
+		corridor[getNodeCluster(node)] = true;
+	}
+	return true;
+}
+
+/**
+ * Marks clusters that can depend on tile at given position for rebuild.
+ * Neighbours are rebuilt too, as they share border entrances.
+ * @param pos Position of changed tile.
+ */
+void PathfindingHierarchy::invalidate(Position pos)
+{
+	// same range as edge cache in Pathfinding
+	constexpr int range = 3;
+
+	for (auto &graph : _graphs)
+	{
+		if (graph.clusters.empty())
+		{
+			continue;
+		}
+		const int minX = std::max(pos.x - range, 0) / CLUSTER_SIZE;
+		const int maxX = std::min(pos.x + range, _save->getMapSizeX() - 1) / CLUSTER_SIZE;
+		const int minY = std::max(pos.y - range, 0) / CLUSTER_SIZE;
+		const int maxY = std::min(pos.y + range, _save->getMapSizeY() - 1) / CLUSTER_SIZE;
+		for (int cy = minY; cy <= maxY; ++cy)
+		{
+			for (int cx = minX; cx <= maxX; ++cx)
+			{
+				const int cluster = cx + cy * _clustersX;
+				graph.borders[cluster * 2 + 0].dirty = true;
+				graph.borders[cluster * 2 + 1].dirty = true;
+				graph.clusters[cluster].dirty = true;
+				if (cx > 0)
+				{
+					graph.borders[(cluster - 1) * 2 + 0].dirty = true;
+					graph.clusters[cluster - 1].dirty = true;
+				}
+				if (cy > 0)
+				{
+					graph.borders[(cluster - _clustersX) * 2 + 1].dirty = true;
+					graph.clusters[cluster - _clustersX].dirty = true;
+				}
+				if (cx + 1 < _clustersX)
+				{
+					graph.clusters[cluster + 1].dirty = true;
+				}
+				if (cy + 1 < _clustersY)
+				{
+					graph.clusters[cluster + _clustersX].dirty = true;
+				}
+			}
+		}
+	}
+}
+
+}
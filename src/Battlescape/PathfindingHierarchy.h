@@ -0,0 +1,124 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class Pathfinding;
+class BattleUnit;
+
+enum BattleActionMove : char;
+
+/**
+ * Abstract graph over the battlescape map used to speed up long path searches (HPA*).
+ * Map is divided into clusters of map block size that span all levels.
+ * Border tiles where units can cross between two clusters form entrances,
+ * and distances between entrances of one cluster are precomputed from terrain costs.
+ * Result of search on this graph is only a corridor of clusters,
+ * final path is always found by normal A* inside that corridor, so it is validated with real TU costs.
+ * Graph is built lazily and separately for each kind of movement, like the edge cache in Pathfinding.
+ */
+class PathfindingHierarchy
+{
+public:
+	/// Size of one cluster in tiles, same as size of map block.
+	static constexpr int CLUSTER_SIZE = 10;
+
+private:
+	/// Max number of entrances on one border.
+	static constexpr int MAX_ENTRANCES = 256;
+	/// Number of different kinds of movement, same as in Pathfinding edge cache.
+	static constexpr int VARIANTS = 5 * 2 * 2;
+
+	/// Place where units can cross border between two clusters.
+	struct Entrance
+	{
+		/// Tile on each side of border.
+		Position pos[2];
+		/// Cost of crossing from side `i` to other side.
+		int cost[2];
+	};
+
+	/// Border between cluster and its east or south neighbour.
+	struct Border
+	{
+		std::vector<Entrance> entrances;
+		bool dirty = true;
+	};
+
+	/// Part of the map with precomputed distances between its entrances.
+	struct Cluster
+	{
+		/// Abstract nodes in this cluster.
+		std::vector<int> nodes;
+		/// Distances between nodes, `-1` if not connected.
+		std::vector<int> distances;
+		bool dirty = true;
+	};
+
+	/// Abstract graph for one kind of movement.
+	struct Graph
+	{
+		std::vector<Border> borders;
+		std::vector<Cluster> clusters;
+	};
+
+	SavedBattleGame *_save;
+	const Pathfinding *_pathfinding;
+	int _clustersX, _clustersY;
+	Graph _graphs[VARIANTS];
+
+	/// Gets index of movement kind.
+	int getVariant(const BattleUnit *unit, BattleActionMove bam) const;
+	/// Gets cost of one step using only terrain, or -1 if the step is not possible.
+	int getTerrainCost(Position pos, int direction, const BattleUnit *unit, BattleActionMove bam, Position &result) const;
+	/// Gets cluster of given position.
+	int getCluster(Position pos) const { return (pos.x / CLUSTER_SIZE) + (pos.y / CLUSTER_SIZE) * _clustersX; }
+	/// Gets position of given abstract node.
+	Position getNodePosition(const Graph &graph, int node) const;
+	/// Gets cluster of given abstract node.
+	int getNodeCluster(int node) const;
+	/// Rebuilds entrances of one border.
+	void buildBorder(Graph &graph, int border, const BattleUnit *unit, BattleActionMove bam);
+	/// Makes sure cluster and its borders are up to date.
+	Cluster &getClusterData(Graph &graph, int cluster, const BattleUnit *unit, BattleActionMove bam);
+	/// Finds distances from one tile to all tiles in its cluster.
+	void getClusterDistances(int cluster, Position from, const BattleUnit *unit, BattleActionMove bam, std::vector<int> &distances) const;
+	/// Gets index of tile in cluster local tables.
+	int getClusterTileIndex(int cluster, Position pos) const;
+public:
+	/// Creates hierarchy for given map.
+	PathfindingHierarchy(SavedBattleGame *save, const Pathfinding *pathfinding);
+	/// Cleans up the hierarchy.
+	~PathfindingHierarchy();
+	/// Is the path long enough to be worth using the hierarchy?
+	bool isLongPath(Position start, Position end) const;
+	/// Finds clusters that path between two positions should go through.
+	bool findCorridor(const BattleUnit *unit, BattleActionMove bam, Position start, Position end, std::vector<bool> &corridor);
+	/// Checks if position is inside of corridor.
+	bool isInCorridor(const std::vector<bool> &corridor, Position pos) const { return corridor[getCluster(pos)]; }
+	/// Marks clusters near changed terrain for rebuild.
+	void invalidate(Position pos);
+};
+
+}
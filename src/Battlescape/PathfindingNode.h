@@ -79,6 +79,30 @@ struct PathfindingStep
 	Position pos = { };
 };
 
+/**
+ * Terrain part of one step in pathfinding algorithm.
+ * Depends only on terrain, so it can be cached until terrain near the step changes.
+ */
+struct PathfindingEdge
+{
+	enum State : Uint8 { EDGE_UNKNOWN, EDGE_INVALID, EDGE_VALID };
+
+	/// Cost of each unit part, before fire, smoke and strafing are added.
+	Uint8 partCost[4] = { };
+	/// Is this step possible or not computed yet.
+	Uint8 state = EDGE_UNKNOWN;
+	/// Level change caused by stairs or falling down.
+	Sint8 levelChange = 0;
+	/// Parts whose destination floor is blocked, if no unit decides otherwise.
+	Uint8 floorBlockedMask = 0;
+	/// Parts that need check for flying units overlapping destination.
+	Uint8 overlappingMask = 0;
+	/// Is the unit falling down?
+	bool fallingDown = false;
+	/// Is the unit flying?
+	bool flying = false;
+};
+
 /**
  * A class that holds pathfinding info for a certain node on the map.
  */
@@ -95,7 +119,11 @@ private:
 	bool _checked;
 	// Invasive field needed by PathfindingOpenSet
 	Uint8 _openentry;
+	// Invasive fields needed by PathfindingBucketOpenSet
+	int _openBucket;
+	int _openBucketIndex;
 	friend class PathfindingOpenSet;
+	friend class PathfindingBucketOpenSet;
 public:
 	/// Creates a new PathfindingNode class.
 	PathfindingNode(Position pos);
@@ -17,17 +17,25 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <assert.h>
+#include <algorithm>
 #include "PathfindingOpenSet.h"
 #include "PathfindingNode.h"
 
 namespace OpenXcom
 {
 
+namespace
+{
+
 /**
- * Cleans up all the entries still in set.
+ * Gets the cost used to order nodes in the open set.
+ * @param node A pointer to the node.
+ * @return Ordering cost.
  */
-PathfindingOpenSet::~PathfindingOpenSet()
+int getOpenSetCost(const PathfindingNode *node)
 {
+	return node->getTUCost(false).time * 4 + node->getTUGuess(); //HACK: this is not real cost, more rough approximation for algorithm, as bonus `getTUGuess` work more like gravity/potential than normal cost.
+}
 
 }
 
@@ -72,10 +80,103 @@ void PathfindingOpenSet::push(PathfindingNode *node)
 
 	OpenSetEntry entry = {};
 	entry._node = node;
-	entry._cost = node->getTUCost(false).time * 4 + node->getTUGuess(); //HACK: this is not real cost, more rough approximation for algorithm, as bonus `getTUGuess` work more like gravity/potential than normal cost.
+	entry._cost = getOpenSetCost(node);
 	entry._openentry = ++node->_openentry; // next unique number, used to check if old recode is still valid.
 	_queue.push(entry);
 }
 
 
+/**
+ * Cleans up all the entries still in set.
+ */
+PathfindingBucketOpenSet::~PathfindingBucketOpenSet()
+{
+
+}
+
+/**
+ * Removes the node from the bucket it is currently in.
+ * Last node of the bucket takes its place, so this is constant time.
+ * @param node A pointer to the node to remove.
+ */
+void PathfindingBucketOpenSet::remove(PathfindingNode *node)
+{
+	auto &bucket = _buckets[node->_openBucket];
+	auto *last = bucket.back();
+	bucket[node->_openBucketIndex] = last;
+	last->_openBucketIndex = node->_openBucketIndex;
+	bucket.pop_back();
+	node->_openentry = 0;
+	--_count;
+}
+
+/**
+ * Gets the node with the least cost.
+ * After this call, the node is no longer in the set. It is an error to call this when the set is empty.
+ * @return A pointer to the node which had the least cost.
+ */
+PathfindingNode *PathfindingBucketOpenSet::pop()
+{
+	assert(!empty());
+
+	while (_buckets[_minBucket].empty())
+	{
+		++_minBucket;
+	}
+	auto &bucket = _buckets[_minBucket];
+	PathfindingNode *nd = bucket.back();
+	bucket.pop_back();
+	nd->_openentry = 0;
+	--_count;
+	return nd;
+}
+
+/**
+ * Places the node in the set.
+ * If the node was already in the set, it is moved to the bucket of its new cost.
+ * Unlike PathfindingOpenSet, a cost lower than the current minimum is allowed,
+ * the scan simply restarts from that bucket.
+ * @param node A pointer to the node to add.
+ */
+void PathfindingBucketOpenSet::push(PathfindingNode *node)
+{
+	if (node->inOpenSet())
+	{
+		remove(node);
+	}
+
+	const int cost = std::max(getOpenSetCost(node), 0);
+	if (cost >= (int)_buckets.size())
+	{
+		_buckets.resize(cost + 1);
+	}
+	auto &bucket = _buckets[cost];
+	node->_openentry = 1;
+	node->_openBucket = cost;
+	node->_openBucketIndex = (int)bucket.size();
+	bucket.push_back(node);
+	++_count;
+
+	if (_count == 1 || cost < _minBucket)
+	{
+		_minBucket = cost;
+	}
+	_maxBucket = std::max(_maxBucket, cost);
+}
+
+/**
+ * Removes all nodes from the set, keeping allocated buckets for the next search.
+ * Nodes themselves are not touched, they are expected to be reset by the caller.
+ */
+void PathfindingBucketOpenSet::clear()
+{
+	for (int i = _minBucket; i <= _maxBucket; ++i)
+	{
+		_buckets[i].clear();
+	}
+	_minBucket = 0;
+	_maxBucket = -1;
+	_count = 0;
+}
+
 }
@@ -18,6 +18,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <queue>
+#include <vector>
 #include <SDL_stdinc.h>
 
 namespace OpenXcom
@@ -56,8 +57,6 @@ public:
 class PathfindingOpenSet
 {
 public:
-	/// Cleans up the set and frees allocated memory.
-	~PathfindingOpenSet();
 	/// Gets the next node to check.
 	PathfindingNode *pop();
 	/// Adds a node to the set.
@@ -72,4 +71,39 @@ private:
 	void removeDiscarded();
 };
 
+/**
+ * A bucket queue (Dial's algorithm) version of PathfindingOpenSet.
+ * Costs are small non-negative integers, so every cost gets its own bucket
+ * and finding the best node is a linear scan from the last known minimum.
+ * Nodes that are pushed again are moved between buckets (decrease-key),
+ * so there are no discarded entries left behind.
+ * Buckets are kept between searches to avoid reallocations.
+ */
+class PathfindingBucketOpenSet
+{
+public:
+	/// Cleans up the set and frees allocated memory.
+	~PathfindingBucketOpenSet();
+	/// Gets the next node to check.
+	PathfindingNode *pop();
+	/// Adds a node to the set or moves it to the bucket of its new cost.
+	void push(PathfindingNode *node);
+	/// Is the set empty?
+	bool empty() const { return _count == 0; }
+	/// Removes all nodes from the set.
+	void clear();
+
+private:
+	std::vector<std::vector<PathfindingNode*>> _buckets;
+	/// Lowest bucket that could be non empty.
+	int _minBucket = 0;
+	/// Highest bucket that was used since last clear.
+	int _maxBucket = -1;
+	/// Number of nodes in the set.
+	int _count = 0;
+
+	/// Removes node from its current bucket.
+	void remove(PathfindingNode *node);
+};
+
 }
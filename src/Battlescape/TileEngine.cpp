@@ -17,7 +17,9 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <assert.h>
+#include <algorithm>
 #include <set>
+#include <climits>
 #include "TileEngine.h"
 #include "AIModule.h"
 #include "Map.h"
@@ -40,6 +42,7 @@
 #include "../Mod/RuleSkill.h"
 #include "Pathfinding.h"
 #include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
 #include "ProjectileFlyBState.h"
 #include "MeleeAttackBState.h"
 #include "../Savegame/BattleObject.h"
@@ -50,6 +53,21 @@ namespace OpenXcom
 namespace
 {
 
+/// Packed terrain voxels of tile were not calculated yet.
+constexpr Uint16 VoxelTerrainUnknown = 0xFFFF;
+/// Tile do not have any terrain voxels.
+constexpr Uint16 VoxelTerrainEmpty = 0;
+/// Too many different tiles, this one is always checked the slow way.
+constexpr Uint16 VoxelTerrainSlow = 0xFFFE;
+
+/// Shape used when packed terrain voxels are not available, always require full check.
+const std::array<Uint16, TileEngine::voxelTerrainRows> VoxelTerrainSolid = []
+{
+	std::array<Uint16, TileEngine::voxelTerrainRows> shape;
+	shape.fill(0xFFFF);
+	return shape;
+}();
+
 /**
  * Calculates a line trajectory, using bresenham algorithm in 3D.
  * @param origin Origin.
@@ -344,6 +362,7 @@ constexpr int TileEngine::heightFromCenter[11];
 constexpr Position TileEngine::invalid;
 constexpr Position TileEngine::voxelTileSize;
 constexpr Position TileEngine::voxelTileCenter;
+constexpr int TileEngine::voxelTerrainRows;
 
 /**
  * Sets up a TileEngine.
@@ -353,14 +372,43 @@ constexpr Position TileEngine::voxelTileCenter;
  * @param maxDarknessToSeeUnits Threshold of darkness for LoS calculation.
  */
 TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
-	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheTile(0), _cacheTileBelow(0),
+	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _voxelTerrainComplete(false),
 	_maxViewDistance(mod->getMaxViewDistance()), _maxViewDistanceSq(_maxViewDistance * _maxViewDistance),
 	_maxVoxelViewDistance(_maxViewDistance * 16), _maxDarknessToSeeUnits(mod->getMaxDarknessToSeeUnits()),
 	_maxStaticLightDistance(mod->getMaxStaticLightDistance()), _maxDynamicLightDistance(mod->getMaxDynamicLightDistance()),
 	_enhancedLighting(mod->getEnhancedLighting())
 {
 	_blockVisibility.resize(save->getMapSizeXYZ());
-	_cacheTilePos = invalid;
+	_voxelTerrainIndex.resize(save->getMapSizeXYZ(), VoxelTerrainUnknown);
+
+	_explosionRayLength = 0;
+	_explosionCurrentGeneration = 0;
+
+	// distances and cone directions of tiles around a light source, same for every source
+	_lightTableRadius = std::min(std::max(getMaxStaticLightDistance(), getMaxDynamicLightDistance()), maxLightTableRadius);
+	const int tableSizeXY = 2 * _lightTableRadius + 1;
+	const int tableSizeZ = 2 * _save->getMapSizeZ() - 1;
+	const Position coneOffsets[] = { Position(6, 6, 0), Position(-6,-6, 0), Position(-6, 6, 0), Position(6, -6, 0) };
+	_lightDistance.resize(tableSizeXY * tableSizeXY * tableSizeZ);
+	_lightConeDirection.resize(tableSizeXY * tableSizeXY);
+	for (int z = 0; z < tableSizeZ; ++z)
+	{
+		for (int y = 0; y < tableSizeXY; ++y)
+		{
+			for (int x = 0; x < tableSizeXY; ++x)
+			{
+				const Position diff = Position(x - _lightTableRadius, y - _lightTableRadius, z - (_save->getMapSizeZ() - 1));
+				_lightDistance[(z * tableSizeXY + y) * tableSizeXY + x] = (int)Round(Position::distance(diff.toVoxel(), Position(0, 0, 0)) / Position::TileXY);
+				if (diff.z == 0)
+				{
+					for (int i = 0; i < 4; ++i)
+					{
+						_lightConeDirection[y * tableSizeXY + x][i] = getDirectionTo(coneOffsets[i], diff.toVoxel());
+					}
+				}
+			}
+		}
+	}
 
 	if (Options::oxceTogglePersonalLightType == 2)
 	{
@@ -393,32 +441,36 @@ void TileEngine::calculateSunShading(MapSubset gs)
 {
 	int power = 15 - _save->getGlobalShade();
 
-	iterateTiles(
-		_save,
-		gs,
-		[&](Tile* tile)
-		{
-			auto currLight = power;
+	// At night/dusk sun isn't dropping shades blocked by roofs
+	if (_save->getGlobalShade() > 4)
+	{
+		iterateTiles(
+			_save,
+			gs,
+			[&](Tile* tile)
+			{
+				tile->addLight(power, LL_AMBIENT);
+			}
+		);
+		return;
+	}
 
-			// At night/dusk sun isn't dropping shades blocked by roofs
-			if (_save->getGlobalShade() <= 4)
+	// go down each column once, summing blockage of all tiles above current one
+	gs = MapSubset::intersection(gs, MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() });
+	for (int y = gs.beg_y; y < gs.end_y; ++y)
+	{
+		for (int x = gs.beg_x; x < gs.end_x; ++x)
+		{
+			int block = 0;
+			for (int z = _save->getMapSizeZ() - 1; z >= 0; z--)
 			{
-				int block = 0;
-				int x = tile->getPosition().x;
-				int y = tile->getPosition().y;
-				for (int z = _save->getMapSizeZ()-1; z > tile->getPosition().z ; z--)
-				{
-					block += blockage(_save->getTile(Position(x, y, z)), O_FLOOR, DT_NONE);
-					block += blockage(_save->getTile(Position(x, y, z)), O_OBJECT, DT_NONE, Pathfinding::DIR_DOWN);
-				}
-				if (block>0)
-				{
-					currLight -= 2;
-				}
+				Tile *tile = _save->getTile(Position(x, y, z));
+				tile->addLight(block > 0 ? power - 2 : power, LL_AMBIENT);
+				block += blockage(tile, O_FLOOR, DT_NONE);
+				block += blockage(tile, O_OBJECT, DT_NONE, Pathfinding::DIR_DOWN);
 			}
-			tile->addLight(currLight, LL_AMBIENT);
 		}
-	);
+	}
 }
 
 /// amount of light a fire generates from tile
@@ -675,6 +727,22 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 	if (layer <= LL_UNITS) calculateUnitLighting(gsDynamic);
 }
 
+/**
+ * Gets index of offset from light source in precomputed light tables.
+ * @param diff Offset of target tile from light source.
+ * @return Index in distance table or -1 if offset is outside of tables.
+ */
+int TileEngine::getLightTableIndex(Position diff) const
+{
+	const int sizeXY = 2 * _lightTableRadius + 1;
+	const int maxZ = _save->getMapSizeZ() - 1;
+	if (!Options::oxceLightTables || std::abs(diff.x) > _lightTableRadius || std::abs(diff.y) > _lightTableRadius || std::abs(diff.z) > maxZ)
+	{
+		return -1;
+	}
+	return ((diff.z + maxZ) * sizeXY + (diff.y + _lightTableRadius)) * sizeXY + (diff.x + _lightTableRadius);
+}
+
 /**
  * Adds circular light pattern starting from center and losing power with distance travelled.
  * @param center Center.
@@ -711,7 +779,8 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 		{
 			const auto target = tile->getPosition();
 			const auto diff = target - center;
-			const auto distance = (int)Round(Position::distance(target.toVoxel(), center.toVoxel()) / Position::TileXY);
+			const auto tableIndex = getLightTableIndex(diff);
+			const auto distance = tableIndex >= 0 ? _lightDistance[tableIndex] : (int)Round(Position::distance(target.toVoxel(), center.toVoxel()) / Position::TileXY);
 			const auto targetLight = tile->getLightMulti(layer);
 			auto currLight = power - distance;
 
@@ -722,13 +791,14 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 
 			if (coneSize > 0)
 			{
-				auto o = { Position(6, 6, 0), Position(-6,-6, 0), Position(-6, 6, 0), Position(6, -6, 0) };
+				const Position o[] = { Position(6, 6, 0), Position(-6,-6, 0), Position(-6, 6, 0), Position(6, -6, 0) };
 				const int hitsMax = 2 * std::size(o);
+				const int coneIndex = tableIndex >= 0 ? getLightTableIndex(Position(diff.x, diff.y, 0)) % (int)_lightConeDirection.size() : -1;
 				int hits = hitsMax;
-				for (const auto& offset : o)
+				for (int i = 0; i < (int)std::size(o); ++i)
 				{
-					auto centerTemp = center.toVoxel() + offset;
-					int tileDir = getDirectionTo(centerTemp, target.toVoxel());
+					auto centerTemp = center.toVoxel() + o[i];
+					int tileDir = coneIndex >= 0 ? _lightConeDirection[coneIndex][i] : getDirectionTo(centerTemp, target.toVoxel());
 					int arc = getArcDirection(direction, tileDir);
 					if (distance == 0)
 					{
@@ -1055,6 +1125,193 @@ void TileEngine::calculateUnitsForLoSPreview(std::vector<BattleUnit *> *visibleU
 	}
 }
 
+/**
+ * Adds tile to tiles visible by unit, and marks it and walls next to it as discovered.
+ * @param unit Unit that see the tile.
+ * @param pos Position of the tile.
+ */
+void TileEngine::addVisibleTile(BattleUnit *unit, Position pos)
+{
+	Tile *tile = _save->getTile(pos);
+	if (!unit->hasVisibleTile(tile))
+	{
+		unit->addToVisibleTiles(tile);
+		tile->setVisible(+1);
+		tile->setDiscovered(true, O_FLOOR);
+
+		// TODO: Check if the tile contains a Smart Object and add it to visible objects if so.
+		if (tile->getBattleObject())
+		{
+			unit->addToVisibleBattleObjects(tile->getBattleObject());
+		}
+
+		// walls to the east or south of a visible tile, we see that too
+		Tile* t = _save->getTile(Position(pos.x + 1, pos.y, pos.z));
+		if (t) t->setDiscovered(true, O_WESTWALL);
+		t = _save->getTile(Position(pos.x, pos.y + 1, pos.z));
+		if (t) t->setDiscovered(true, O_NORTHWALL);
+	}
+}
+
+/**
+ * Gets tree of all lines of sight that `calculateTilesInFOV` checks for one view direction,
+ * built once from same bresenham lines as `calculateLineTile` use.
+ * Lines are stored relative to the eye, and all levels of the map are covered.
+ * @param direction View direction.
+ * @param eye Index of eye of large unit, x + y * 2.
+ * @return Nodes of tree, first one is the eye.
+ */
+const std::vector<TileEngine::SightNode> &TileEngine::getSightTree(int direction, int eye)
+{
+	auto& tree = _sightTrees[direction * 4 + eye];
+	if (!tree.empty())
+	{
+		return tree;
+	}
+
+	struct BuildNode
+	{
+		SightNode node;
+		std::vector<int> children;
+	};
+	std::vector<BuildNode> build;
+	std::vector<int> path;
+	const Position eyeOffset = Position(eye % 2, eye / 2, 0);
+	const Position zero = Position(0, 0, 0);
+
+	auto addNode = [&](Position pos, Position parent)
+	{
+		BuildNode b;
+		b.node.pos = pos;
+		b.node.targetMin = Position(SHRT_MAX, SHRT_MAX, SHRT_MAX);
+		b.node.targetMax = Position(SHRT_MIN, SHRT_MIN, SHRT_MIN);
+		b.node.dir = Pathfinding::vectorToDirection(pos - parent);
+		b.node.dz = pos.z - parent.z;
+		b.node.target = false;
+		build.push_back(b);
+		return (int)build.size() - 1;
+	};
+	auto addTarget = [&](int node, Position target)
+	{
+		auto& n = build[node].node;
+		n.targetMin = Position(std::min(n.targetMin.x, target.x), std::min(n.targetMin.y, target.y), std::min(n.targetMin.z, target.z));
+		n.targetMax = Position(std::max(n.targetMax.x, target.x), std::max(n.targetMax.y, target.y), std::max(n.targetMax.z, target.z));
+	};
+	addNode(zero, zero);
+
+	//Same view cone as in calculateTilesInFOV.
+	bool swap = (direction == 0 || direction == 4);
+	const int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
+	const int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
+	const int maxZ = _save->getMapSizeZ() - 1;
+	for (int x = 0; x <= getMaxViewDistance(); ++x)
+	{
+		int y1 = (direction & 1) ? 0 : -x;
+		int y2 = (direction & 1) ? getMaxViewDistance() : x;
+		for (int y = y1; y <= y2; ++y)
+		{
+			if (x*x + y*y > getMaxViewDistanceSq())
+			{
+				continue;
+			}
+			for (int z = -maxZ; z <= maxZ; ++z)
+			{
+				Position target = Position(signX[direction] * (swap ? y : x), signY[direction] * (swap ? x : y), z) - eyeOffset;
+				int node = -1;
+				path.clear();
+				calculateLineHelper(zero, target,
+					[&](Position point)
+					{
+						if (node == -1)
+						{
+							node = 0;
+						}
+						else
+						{
+							int child = -1;
+							for (int c : build[node].children)
+							{
+								if (build[c].node.pos == point)
+								{
+									child = c;
+									break;
+								}
+							}
+							if (child == -1)
+							{
+								child = addNode(point, build[node].node.pos);
+								build[node].children.push_back(child);
+							}
+							node = child;
+						}
+						path.push_back(node);
+						return false;
+					},
+					[&](Position point)
+					{
+						return false;
+					}
+				);
+				build[node].node.target = true;
+				for (int n : path)
+				{
+					addTarget(n, target);
+				}
+			}
+		}
+	}
+
+	//Flatten tree, children of each node are stored next to each other.
+	tree.resize(build.size());
+	std::vector<int> order;
+	order.reserve(build.size());
+	order.push_back(0);
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const auto& b = build[order[i]];
+		tree[i] = b.node;
+		tree[i].firstChild = (int)order.size();
+		tree[i].childCount = (int)b.children.size();
+		order.insert(order.end(), b.children.begin(), b.children.end());
+	}
+	return tree;
+}
+
+/**
+ * Checks if any line of sight going through node of tree ends inside of the map.
+ * Lines with end outside of the map are never checked by `calculateTilesInFOV`.
+ * @param tree Tree of lines.
+ * @param node Node to check.
+ * @param eye Position of the eye.
+ * @return True if the node is on some checked line.
+ */
+bool TileEngine::hasSightTarget(const std::vector<SightNode> &tree, int node, Position eye) const
+{
+	const SightNode &n = tree[node];
+	const Position min = eye + n.targetMin;
+	const Position max = eye + n.targetMax;
+	if (min.x >= 0 && min.y >= 0 && min.z >= 0 && max.x < _save->getMapSizeX() && max.y < _save->getMapSizeY() && max.z < _save->getMapSizeZ())
+	{
+		return true;
+	}
+	if (max.x < 0 || max.y < 0 || max.z < 0 || min.x >= _save->getMapSizeX() || min.y >= _save->getMapSizeY() || min.z >= _save->getMapSizeZ())
+	{
+		return false;
+	}
+	if (n.target && _save->getTile(eye + n.pos))
+	{
+		return true;
+	}
+	for (int c = n.firstChild; c < n.firstChild + n.childCount; ++c)
+	{
+		if (hasSightTarget(tree, c, eye))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
 * Calculates line of sight of tiles for a player controlled soldier.
 * If supplied with an event position differing from the soldier's position, it will only
@@ -1116,6 +1373,71 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 			++posSelf.z;
 		}
 	}
+	if (skipNarrowArcTest && Options::oxceSightTree)
+	{
+		//Full check, walk tree of all lines of sight from each eye. Line beginnings shared by many lines are checked only once
+		//and a blocked node cuts off all lines behind it. Gives the same tiles as checking each line separately below.
+		struct SightStep
+		{
+			int node;
+			Position lastPoint;
+			int steps;
+		};
+		std::vector<SightStep> stack;
+		int size = unit->getArmor()->getSize();
+		for (int xo = 0; xo < size; xo++)
+		{
+			for (int yo = 0; yo < size; yo++)
+			{
+				Position poso = posSelf + Position(xo, yo, 0);
+				const auto& tree = getSightTree(direction, xo + yo * 2);
+				stack.push_back({ 0, poso, 0 });
+				while (!stack.empty())
+				{
+					SightStep step = stack.back();
+					stack.pop_back();
+
+					const SightNode &node = tree[step.node];
+					const auto& cache = _blockVisibility[_save->getTileIndex(step.lastPoint)];
+					bool result = getBlockDir(cache, node.dir, node.dz);
+					bool bigWall = false;
+					if (result && node.dz == 0 && getBigWallDir(cache, node.dir))
+					{
+						if (step.steps < 2)
+						{
+							result = false;
+						}
+						else
+						{
+							bigWall = true;
+						}
+					}
+					if (result && !bigWall)
+					{
+						//Vision impacted something, impact point is not visible.
+						continue;
+					}
+					if (!hasSightTarget(tree, step.node, poso))
+					{
+						//No line going this way is checked, its end is outside of the map.
+						continue;
+					}
+					Position point = poso + node.pos;
+					addVisibleTile(unit, point);
+					if (result)
+					{
+						continue;
+					}
+					for (int c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+					{
+						stack.push_back({ c, point, step.steps + 1 });
+					}
+				}
+			}
+		}
+		return;
+	}
+
 	//Test all tiles within view cone for visibility.
 	for (int x = 0; x <= getMaxViewDistance(); ++x) //TODO: Possible improvement: find the intercept points of the arc at max view distance and choose a more intelligent sweep of values when an event arc is defined.
 	{
@@ -1163,27 +1485,9 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 									//Reveal all tiles along line of vision. Note: needed due to width of bresenham stroke.
 									for (std::vector<Position>::iterator i = _trajectory.begin(); i != _trajectory.end(); ++i)
 									{
-										Position posVisited = (*i);
 										//Add tiles to the visible list only once. BUT we still need to calculate the whole trajectory as
 										// this bresenham line's period might be different from the one that originally revealed the tile.
-										if (!unit->hasVisibleTile(_save->getTile(posVisited)))
-										{
-											unit->addToVisibleTiles(_save->getTile(posVisited));
-											_save->getTile(posVisited)->setVisible(+1);
-											_save->getTile(posVisited)->setDiscovered(true, O_FLOOR);
-
-											// TODO: Check if the tile contains a Smart Object and add it to visible objects if so.
-											if (_save->getTile(posVisited)->getBattleObject())
-											{
-												unit->addToVisibleBattleObjects(_save->getTile(posVisited)->getBattleObject());
-											}
-
-											// walls to the east or south of a visible tile, we see that too
-											Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
-											if (t) t->setDiscovered(true, O_WESTWALL);
-											t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
-											if (t) t->setDiscovered(true, O_NORTHWALL);
-										}
+										addVisibleTile(unit, (*i));
 									}
 								}
 							}
@@ -1667,6 +1971,43 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
  * @return True if the unit can be targetted.
  */
 bool TileEngine::canTargetUnit(Position *originVoxel, Tile *tile, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles, BattleUnit *potentialUnit)
+{
+	return canTargetUnitImpl(_voxelCheckCache, originVoxel, tile, scanVoxel, excludeUnit, rememberObstacles, potentialUnit);
+}
+
+/**
+ * Checks for many units at once if they can be targeted, each query is same as call to `canTargetUnit` without remembering obstacles.
+ * Queries are split between threads of the shared pool, each one with own voxel check cache,
+ * map is only read so results are the same as when checked one by one.
+ * @param queries Queries to check, result and scan voxel of each one are set.
+ */
+void TileEngine::canTargetUnits(std::vector<TargetUnitQuery> &queries)
+{
+	if (queries.size() < 2 || !Options::oxceParallelLineOfFire)
+	{
+		for (auto& q : queries)
+		{
+			q.result = canTargetUnitImpl(_voxelCheckCache, &q.originVoxel, q.tile, &q.scanVoxel, q.excludeUnit, false, q.potentialUnit);
+		}
+		return;
+	}
+
+	// lazy parts of voxel cache need to be ready before other threads use it
+	prepareTerrainVoxels();
+	ThreadPool::getShared().run((int)queries.size(),
+		[&](int i)
+		{
+			VoxelCheckCache cache;
+			auto& q = queries[i];
+			q.result = canTargetUnitImpl(cache, &q.originVoxel, q.tile, &q.scanVoxel, q.excludeUnit, false, q.potentialUnit);
+		}
+	);
+}
+
+/**
+ * Checks for another unit available for targeting, using given voxel check cache.
+ */
+bool TileEngine::canTargetUnitImpl(VoxelCheckCache &cache, Position *originVoxel, Tile *tile, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles, BattleUnit *potentialUnit)
 {
 	Position targetVoxel = tile->getPosition().toVoxel() + Position(7, 8, 0);
 	std::vector<Position> _trajectory;
@@ -1728,7 +2069,7 @@ bool TileEngine::canTargetUnit(Position *originVoxel, Tile *tile, Position *scan
 			scanVoxel->x=targetVoxel.x + sliceTargets[j*2];
 			scanVoxel->y=targetVoxel.y + sliceTargets[j*2+1];
 			_trajectory.clear();
-			int test = calculateLineVoxel(*originVoxel, *scanVoxel, false, &_trajectory, excludeUnit);
+			int test = calculateLineVoxelImpl(cache, *originVoxel, *scanVoxel, false, &_trajectory, excludeUnit, nullptr, false);
 			if (test == V_UNIT)
 			{
 				for (int x = 0; x <= targetSize; ++x)
@@ -1955,9 +2296,11 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
 		updateRadius = getMaxViewDistance() + (eventRadius > 0 ? eventRadius : 0);
 		updateRadius *= updateRadius;
 	}
-	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	std::vector<BattleUnit*> nearUnits;
+	_save->getUnitsInRadius(position, (int)ceil(sqrt(updateRadius)), nearUnits);
+	for (BattleUnit *unit : nearUnits)
 	{
-		const auto posUnit = (*i)->getPosition();
+		const auto posUnit = unit->getPosition();
 
 		if (Position::distance2dSq(position, posUnit) <= updateRadius) //could this unit have observed the event?
 		{
@@ -1965,17 +2308,17 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
 			{
 				if (!appendToTileVisibility)
 				{
-					(*i)->clearVisibleTiles();
-					(*i)->clearVisibleBattleObjects();
+					unit->clearVisibleTiles();
+					unit->clearVisibleBattleObjects();
 				}
-				calculateTilesInFOV((*i), position, eventRadius);
+				calculateTilesInFOV(unit, position, eventRadius);
 			}
 
-			calculateUnitsInFOV((*i), position, eventRadius);
-			if (_save->isStealthMission() && (*i)->getFaction() == FACTION_HOSTILE
-				&& !(*i)->getUnitWarned() && !(*i)->isOut())
+			calculateUnitsInFOV(unit, position, eventRadius);
+			if (_save->isStealthMission() && unit->getFaction() == FACTION_HOSTILE
+				&& !unit->getUnitWarned() && !unit->isOut())
 			{
-				checkForSuspiciousItems((*i));
+				checkForSuspiciousItems(unit);
 			}
 		}
 	}
@@ -2074,33 +2417,31 @@ bool TileEngine::checkReactionFire(BattleUnit *unit, const BattleAction &origina
 std::vector<TileEngine::ReactionScore> TileEngine::getSpottingUnits(BattleUnit* unit)
 {
 	std::vector<TileEngine::ReactionScore> spotters;
+	std::vector<BattleUnit*> candidates;
+	std::vector<TargetUnitQuery> queries;
 	Tile *tile = unit->getTile();
 	int threshold = unit->getReactionScore();
 	// no reaction on civilian turn.
 	if (_save->getSide() != FACTION_NEUTRAL || _save->getGeoscapeSave()->isFtAGame())
 	{
-		for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+		std::vector<BattleUnit*> nearUnits;
+		_save->getUnitsInRadius(unit->getPosition(), getMaxViewDistance(), nearUnits, SavedBattleGame::UNIT_INDEX_ALL_FACTIONS & ~(1 << _save->getSide()));
+		for (BattleUnit *spotter : nearUnits)
 		{
 				// not dead/unconscious
-			if (!(*i)->isOut() &&
+			if (!spotter->isOut() &&
 				// not dying or not about to pass out
-				!(*i)->isOutThresholdExceed() &&
+				!spotter->isOutThresholdExceed() &&
 				// have any chances for reacting
-				(*i)->getReactionScore() >= threshold &&
+				spotter->getReactionScore() >= threshold &&
 				// not a friend
-				(*i)->getFaction() != _save->getSide() &&
+				spotter->getFaction() != _save->getSide() &&
 				// not a civilian, or a civilian shooting at bad non-ignored guys
-				((*i)->getFaction() != FACTION_NEUTRAL || (unit->getFaction() == FACTION_HOSTILE && !unit->isIgnoredByAI())) &&
+				(spotter->getFaction() != FACTION_NEUTRAL || (unit->getFaction() == FACTION_HOSTILE && !unit->isIgnoredByAI())) &&
 				// closer than 20 tiles
-				Position::distance2dSq(unit->getPosition(), (*i)->getPosition()) <= getMaxViewDistanceSq())
+				Position::distance2dSq(unit->getPosition(), spotter->getPosition()) <= getMaxViewDistanceSq())
 			{
-				BattleAction falseAction;
-				falseAction.type = BA_SNAPSHOT;
-				falseAction.actor = *i;
-				falseAction.target = unit->getPosition();
-				Position originVoxel = getOriginVoxel(falseAction, 0);
-				Position targetVoxel;
-				AIModule *ai = (*i)->getAIModule();
+				AIModule *ai = spotter->getAIModule();
 
 				// Inquisitor's note regarding 'gotHit' variable
 				// in vanilla, the 'hitState' flag is the only part of this equation that comes into play.
@@ -2117,63 +2458,84 @@ std::vector<TileEngine::ReactionScore> TileEngine::getSpottingUnits(BattleUnit*
 				// we don't extend the same "enhanced aggressor memory" courtesy to players, because in the original, they could only turn and react to damage immediately after it happened.
 				// this is because as much as we want the player's soldiers dead, we don't want them to feel like we're being unfair about it.
 
-				bool gotHit = (ai != 0 && ai->getWasHitBy(unit->getId())) || (ai == 0 && (*i)->getHitState());
+				bool gotHit = (ai != 0 && ai->getWasHitBy(unit->getId())) || (ai == 0 && spotter->getHitState());
 
 				if (!gotHit && Mod::EXTENDED_MELEE_REACTIONS == 2)
 				{
 					// to allow melee reactions when attacked from any side, not just from the front
-					gotHit = (*i)->wasMeleeAttackedBy(unit->getId());
+					gotHit = spotter->wasMeleeAttackedBy(unit->getId());
 				}
 
-					// can actually see the target Tile, or we got hit
-				if (((*i)->checkViewSector(unit->getPosition()) || gotHit) &&
-					// can actually target the unit
-					canTargetUnit(&originVoxel, tile, &targetVoxel, *i, false) &&
-					// can actually see the unit
-					visible(*i, tile))
+				// can actually see the target Tile, or we got hit
+				if (spotter->checkViewSector(unit->getPosition()) || gotHit)
 				{
-					if ((*i)->getFaction() == FACTION_HOSTILE && !unit->tryUncover() && !(*i)->getUnitWarned())
-					{
-						continue;
-					}
-					if ((*i)->getFaction() == FACTION_PLAYER)
-					{
-						unit->setVisible(true);
-					}
-					(*i)->addToVisibleUnits(unit);
-					ReactionScore rs = determineReactionType(*i, unit);
-					if (rs.attackType != BA_NONE)
+					BattleAction falseAction;
+					falseAction.type = BA_SNAPSHOT;
+					falseAction.actor = spotter;
+					falseAction.target = unit->getPosition();
+
+					TargetUnitQuery query = { };
+					query.originVoxel = getOriginVoxel(falseAction, 0);
+					query.tile = tile;
+					query.excludeUnit = spotter;
+					candidates.push_back(spotter);
+					queries.push_back(query);
+				}
+			}
+		}
+
+		// lines of fire of all candidates are independent, check them at once
+		canTargetUnits(queries);
+
+		for (size_t c = 0; c < candidates.size(); ++c)
+		{
+			BattleUnit *spotter = candidates[c];
+				// can actually target the unit
+			if (queries[c].result &&
+				// can actually see the unit
+				visible(spotter, tile))
+			{
+				if (spotter->getFaction() == FACTION_HOSTILE && !unit->tryUncover() && !spotter->getUnitWarned())
+				{
+					continue;
+				}
+				if (spotter->getFaction() == FACTION_PLAYER)
+				{
+					unit->setVisible(true);
+				}
+				spotter->addToVisibleUnits(unit);
+				ReactionScore rs = determineReactionType(spotter, unit);
+				if (rs.attackType != BA_NONE)
+				{
+					if (rs.attackType == BA_SNAPSHOT && Options::battleUFOExtenderAccuracy)
 					{
-						if (rs.attackType == BA_SNAPSHOT && Options::battleUFOExtenderAccuracy)
+						BattleItem *weapon = rs.weapon;
+						int accuracy = BattleUnit::getFiringAccuracy(BattleActionAttack::GetBeforeShoot(rs.attackType, rs.unit, weapon), _save->getBattleGame()->getMod());
+						int distanceSq = unit->distance3dToUnitSq(spotter);
+						int distance = (int)std::ceil(sqrt(float(distanceSq)));
+
+						int upperLimit = weapon->getRules()->getSnapRange();
+						int lowerLimit = weapon->getRules()->getMinRange();
+						if (distance > upperLimit)
 						{
-							BattleItem *weapon = rs.weapon;
-							int accuracy = BattleUnit::getFiringAccuracy(BattleActionAttack::GetBeforeShoot(rs.attackType, rs.unit, weapon), _save->getBattleGame()->getMod());
-							int distanceSq = unit->distance3dToUnitSq((*i));
-							int distance = (int)std::ceil(sqrt(float(distanceSq)));
-
-							int upperLimit = weapon->getRules()->getSnapRange();
-							int lowerLimit = weapon->getRules()->getMinRange();
-							if (distance > upperLimit)
-							{
-								accuracy -= (distance - upperLimit) * weapon->getRules()->getDropoff();
-							}
-							else if (distance < lowerLimit)
-							{
-								accuracy -= (lowerLimit - distance) * weapon->getRules()->getDropoff();
-							}
+							accuracy -= (distance - upperLimit) * weapon->getRules()->getDropoff();
+						}
+						else if (distance < lowerLimit)
+						{
+							accuracy -= (lowerLimit - distance) * weapon->getRules()->getDropoff();
+						}
 
-							bool outOfRange = weapon->getRules()->isOutOfRange(distanceSq);
+						bool outOfRange = weapon->getRules()->isOutOfRange(distanceSq);
 
-							if (accuracy > _save->getBattleGame()->getMod()->getMinReactionAccuracy() && !outOfRange)
-							{
-								spotters.push_back(rs);
-							}
-						}
-						else
+						if (accuracy > _save->getBattleGame()->getMod()->getMinReactionAccuracy() && !outOfRange)
 						{
 							spotters.push_back(rs);
 						}
 					}
+					else
+					{
+						spotters.push_back(rs);
+					}
 				}
 			}
 		}
@@ -2742,6 +3104,8 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
 			{
 				_save->addDestroyedObjective();
 			}
+			_save->getPathfinding()->invalidateTUCostCache(tile->getPosition());
+			invalidateVoxelCache(tile->getPosition());
 		}
 	}
 	else if (part == V_UNIT)
@@ -2823,16 +3187,29 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
  * @param maxRadius The maximum radius of the explosion.
  * @param unit The unit that caused the explosion.
  * @param clipOrWeapon The clip or weapon that caused the explosion.
+ * @param updateView Update lighting and visibility now, otherwise caller needs to call updateExplosionView later.
  */
-void TileEngine::explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack)
+void TileEngine::explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack, bool updateView)
 {
 	const Position centetTile = center.toTile();
 	int hitSide = 0;
 	int diagonalWall = 0;
 	int power_;
-	std::map<Tile*, int> tilesAffected;
 	std::vector<BattleItem*> toRemove;
-	std::pair<std::map<Tile*, int>::iterator, bool> ret;
+
+	// tiles affected by this explosion are marked with new generation, no need to clear damage of previous ones
+	if (_explosionDamage.empty())
+	{
+		_explosionDamage.resize(_save->getMapSizeXYZ());
+		_explosionGeneration.resize(_save->getMapSizeXYZ());
+	}
+	if (++_explosionCurrentGeneration == 0)
+	{
+		std::fill(_explosionGeneration.begin(), _explosionGeneration.end(), 0);
+		_explosionCurrentGeneration = 1;
+	}
+	_explosionTiles.clear();
+	prepareExplosionRays(maxRadius);
 
 	if (type->FireBlastCalc)
 	{
@@ -2865,159 +3242,180 @@ void TileEngine::explode(BattleActionAttack attack, Position center, int power,
 			hitSide = (center.x % 16 + center.y % 16 - 15) > 0 ? 1 : -1;
 	}
 
-	for (int fi = -90; fi <= 90; fi += 5)
+	for (size_t r = 0; r < _explosionRays.size(); ++r)
 	{
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (int te = 0; te <= 360; te += 3)
-		{
-			double cos_te = cos(Deg2Rad(te));
-			double sin_te = sin(Deg2Rad(te));
-			double sin_fi = sin(Deg2Rad(fi));
-			double cos_fi = cos(Deg2Rad(fi));
+		const ExplosionRay &ray = _explosionRays[r];
+		const ExplosionRayStep *steps = _explosionRaySteps.data() + r * _explosionRayLength;
+		const int te = ray.te;
 
-			origin = _save->getTile(centetTile);
-			dest = origin;
-			double l = 0;
-			int tileX, tileY, tileZ;
-			power_ = power;
-			while (power_ > 0 && l <= maxRadius)
+		origin = _save->getTile(centetTile);
+		dest = origin;
+		double l = 0;
+		int tileX, tileY, tileZ;
+		power_ = power;
+		while (power_ > 0 && l <= maxRadius)
+		{
+			if (power_ > 0)
 			{
-				if (power_ > 0)
+				// check if we had this tile already affected
+				const int tileIndex = _save->getTileIndex(dest->getPosition());
+				const bool firstHit = _explosionGeneration[tileIndex] != _explosionCurrentGeneration;
+				if (firstHit)
 				{
-					ret = tilesAffected.insert(std::make_pair(dest, 0)); // check if we had this tile already affected
+					_explosionGeneration[tileIndex] = _explosionCurrentGeneration;
+					_explosionDamage[tileIndex] = 0;
+					_explosionTiles.push_back(tileIndex);
+				}
 
-					const int tileDmg = type->getTileFinalDamage(power_);
-					if (tileDmg > ret.first->second)
-					{
-						ret.first->second = tileDmg;
-					}
-					if (ret.second)
-					{
-						const int damage = type->getRandomDamage(power_);
-						BattleUnit *bu = dest->getOverlappingUnit(_save);
+				const int tileDmg = type->getTileFinalDamage(power_);
+				if (tileDmg > _explosionDamage[tileIndex])
+				{
+					_explosionDamage[tileIndex] = tileDmg;
+				}
+				if (firstHit)
+				{
+					const int damage = type->getRandomDamage(power_);
+					BattleUnit *bu = dest->getOverlappingUnit(_save);
 
-						toRemove.clear();
-						if (bu)
-						{
-							if (
-									(
-										Position::distance2dSq(dest->getPosition(), centetTile) < 4
-										&& dest->getPosition().z == centetTile.z
-									)
-									|| dest->getPosition().z > centetTile.z
+					toRemove.clear();
+					if (bu)
+					{
+						if (
+								(
+									Position::distance2dSq(dest->getPosition(), centetTile) < 4
+									&& dest->getPosition().z == centetTile.z
 								)
-							{
-								// ground zero effect is in effect, or unit is above explosion
-								hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
-							}
-							else
-							{
-								// directional damage relative to explosion position.
-								// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
-								hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
-							}
+								|| dest->getPosition().z > centetTile.z
+							)
+						{
+							// ground zero effect is in effect, or unit is above explosion
+							hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
+						}
+						else
+						{
+							// directional damage relative to explosion position.
+							// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
+							hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
+						}
 
-							// Affect all items and units in inventory
-							const int itemDamage = bu->getOverKillDamage();
-							if (itemDamage > 0)
+						// Affect all items and units in inventory
+						const int itemDamage = bu->getOverKillDamage();
+						if (itemDamage > 0)
+						{
+							for (std::vector<BattleItem*>::iterator it = bu->getInventory()->begin(); it != bu->getInventory()->end(); ++it)
 							{
-								for (std::vector<BattleItem*>::iterator it = bu->getInventory()->begin(); it != bu->getInventory()->end(); ++it)
+								if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > (*it)->getRules()->getArmor())
 								{
-									if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > (*it)->getRules()->getArmor())
-									{
-										toRemove.push_back(*it);
-									}
+									toRemove.push_back(*it);
 								}
 							}
 						}
-						// Affect all items and units on ground
-						for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
-						{
-							if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > (*it)->getRules()->getArmor())
-							{
-								toRemove.push_back(*it);
-							}
-						}
-						for (std::vector<BattleItem*>::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+					}
+					// Affect all items and units on ground
+					for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
+					{
+						if (!hitUnit(attack, (*it)->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > (*it)->getRules()->getArmor())
 						{
-							_save->removeItem((*it));
+							toRemove.push_back(*it);
 						}
-
-						hitTile(dest, damage, type);
 					}
+					for (std::vector<BattleItem*>::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+					{
+						_save->removeItem((*it));
+					}
+
+					hitTile(dest, damage, type);
 				}
+			}
 
-				l += 1.0;
+			l += 1.0;
+			if (l > maxRadius)
+			{
+				break; // rest of the step would only weaken the ray that ends here
+			}
 
-				tileX = int(floor(centetTile.x + 0.5 + l * sin_te * cos_fi));
-				tileY = int(floor(centetTile.y + 0.5 + l * cos_te * cos_fi));
-				tileZ = int(floor(centetTile.z + 0.5 + l * sin_fi));
+			const ExplosionRayStep &step = steps[(int)l - 1];
+			if (step.recalculate)
+			{
+				tileX = int(floor(centetTile.x + 0.5 + l * ray.sinTe * ray.cosFi));
+				tileY = int(floor(centetTile.y + 0.5 + l * ray.cosTe * ray.cosFi));
+				tileZ = int(floor(centetTile.z + 0.5 + l * ray.sinFi));
+			}
+			else
+			{
+				tileX = centetTile.x + step.offset.x;
+				tileY = centetTile.y + step.offset.y;
+				tileZ = centetTile.z + step.offset.z;
+			}
 
-				origin = dest;
-				dest = _save->getTile(Position(tileX, tileY, tileZ));
+			origin = dest;
+			dest = _save->getTile(Position(tileX, tileY, tileZ));
 
-				if (!dest) break; // out of map!
+			if (!dest) break; // out of map!
 
-				// blockage by terrain is deducted from the explosion power
-				power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
-				if (origin->getPosition().z != tileZ)
-					power_ -= vertdec; //3d explosion factor
+			// blockage by terrain is deducted from the explosion power
+			power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
+			if (origin->getPosition().z != tileZ)
+				power_ -= vertdec; //3d explosion factor
 
-				if (type->FireBlastCalc)
+			if (type->FireBlastCalc)
+			{
+				int dir;
+				Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
+				if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+			}
+			if (l > 0.5) {
+				if ( l > 1.5)
 				{
-					int dir;
-					Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
-					if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+					power_ -= verticalBlockage(origin, dest, type->ResistType, false) * 2;
+					power_ -= horizontalBlockage(origin, dest, type->ResistType, false) * 2;
 				}
-				if (l > 0.5) {
-					if ( l > 1.5)
+				else //tricky bigwall deflection /Volutar
+				{
+					bool skipObject = diagonalWall == 0;
+					if (diagonalWall == Pathfinding::BIGWALLNESW) // --
 					{
-						power_ -= verticalBlockage(origin, dest, type->ResistType, false) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, false) * 2;
+						if (hitSide<0 && te >= 135 && te < 315)
+							skipObject = true;
+						if (hitSide>0 && ( te < 135 || te > 315))
+							skipObject = true;
 					}
-					else //tricky bigwall deflection /Volutar
+					if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
 					{
-						bool skipObject = diagonalWall == 0;
-						if (diagonalWall == Pathfinding::BIGWALLNESW) // --
-						{
-							if (hitSide<0 && te >= 135 && te < 315)
-								skipObject = true;
-							if (hitSide>0 && ( te < 135 || te > 315))
-								skipObject = true;
-						}
-						if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
-						{
-							if (hitSide>0 && te >= 45 && te < 225)
-								skipObject = true;
-							if (hitSide<0 && ( te < 45 || te > 225))
-								skipObject = true;
-						}
-						power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
-
+						if (hitSide>0 && te >= 45 && te < 225)
+							skipObject = true;
+						if (hitSide<0 && ( te < 45 || te > 225))
+							skipObject = true;
 					}
+					power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
+					power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
+
 				}
 			}
 		}
 	}
 
-	// now detonate the tiles affected by explosion
+	// now detonate the tiles affected by explosion, in map order
 	if (type->ToTile > 0.0f)
 	{
-		for (std::map<Tile*, int>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
+		std::sort(_explosionTiles.begin(), _explosionTiles.end());
+		for (int tileIndex : _explosionTiles)
 		{
-			if (detonate(i->first, i->second))
+			Tile *tile = _save->getTile(tileIndex);
+			if (detonate(tile, _explosionDamage[tileIndex]))
 			{
 				_save->addDestroyedObjective();
 			}
-			applyGravity(i->first);
-			Tile *j = _save->getTile(i->first->getPosition() + Position(0,0,1));
+			applyGravity(tile);
+			Tile *j = _save->getTile(tile->getPosition() + Position(0,0,1));
 			if (j)
 				applyGravity(j);
 		}
 	}
-	calculateLighting(LL_AMBIENT, centetTile, maxRadius + 1, true); // roofs could have been destroyed and fires could have been started
-	calculateFOV(centetTile, maxRadius + 1, true, true);
+	if (updateView)
+	{
+		updateExplosionView(centetTile, centetTile, maxRadius);
+	}
 	if (attack.attacker && Position::distance2d(centetTile, attack.attacker->getPosition()) > maxRadius + 1)
 	{
 		// unit is away from blast but its visibility can be affected by scripts.
@@ -3025,6 +3423,77 @@ void TileEngine::explode(BattleActionAttack attack, Position center, int power,
 	}
 }
 
+/**
+ * Makes sure precomputed explosion rays are long enough for given radius.
+ * Rays go every 5 degrees vertically and every 3 degrees horizontally, this makes sure we cover all tiles in a circle.
+ * Tiles of each ray are same for every explosion, only steps that are too close to edge of tile
+ * are calculated from real center of explosion, to not be affected by rounding.
+ * @param maxRadius The maximum radius of the explosion.
+ */
+void TileEngine::prepareExplosionRays(int maxRadius)
+{
+	if (maxRadius <= _explosionRayLength)
+	{
+		return;
+	}
+
+	if (_explosionRays.empty())
+	{
+		for (int fi = -90; fi <= 90; fi += 5)
+		{
+			for (int te = 0; te <= 360; te += 3)
+			{
+				_explosionRays.push_back({ sin(Deg2Rad(te)), cos(Deg2Rad(te)), sin(Deg2Rad(fi)), cos(Deg2Rad(fi)), te });
+			}
+		}
+	}
+
+	auto getOffset = [](double v, bool &recalculate)
+	{
+		const double t = 0.5 + v;
+		if (std::abs(t - std::round(t)) < 1e-6)
+		{
+			recalculate = true;
+		}
+		return (int)floor(t);
+	};
+
+	_explosionRayLength = maxRadius;
+	_explosionRaySteps.resize(_explosionRays.size() * _explosionRayLength);
+	for (size_t r = 0; r < _explosionRays.size(); ++r)
+	{
+		const ExplosionRay &ray = _explosionRays[r];
+		for (int i = 0; i < _explosionRayLength; ++i)
+		{
+			const double l = i + 1;
+			ExplosionRayStep &step = _explosionRaySteps[r * _explosionRayLength + i];
+			step.recalculate = false;
+			step.offset.x = getOffset(l * ray.sinTe * ray.cosFi, step.recalculate);
+			step.offset.y = getOffset(l * ray.cosTe * ray.cosFi, step.recalculate);
+			step.offset.z = getOffset(l * ray.sinFi, step.recalculate);
+		}
+	}
+}
+
+/**
+ * Updates lighting and visibility of area changed by explosions.
+ * @param min Lowest corner of area containing centers of explosions.
+ * @param max Highest corner of area containing centers of explosions.
+ * @param maxRadius The maximum radius of the explosions.
+ */
+void TileEngine::updateExplosionView(Position min, Position max, int maxRadius)
+{
+	const Position center = Position((min.x + max.x) / 2, (min.y + max.y) / 2, min.z);
+	int radius = maxRadius + 1;
+	if (min != max)
+	{
+		// enough to reach corners of area from its rounded center
+		radius += (int)ceil(Position::distance(Position(min.x, min.y, 0), Position(max.x, max.y, 0)) / 2) + 1;
+	}
+	calculateLighting(LL_AMBIENT, center, radius, true); // roofs could have been destroyed and fires could have been started
+	calculateFOV(center, radius, true, true);
+}
+
 /**
  * Applies the explosive power to the tile parts. This is where the actual destruction takes place.
  * Must affect 9 objects (6 box sides and the object inside plus 2 outer walls).
@@ -3106,6 +3575,8 @@ bool TileEngine::detonate(Tile* tile, int explosive)
 				currentpart2 = currentpart;
 			if (tiles[i]->destroy(currentpart, _save->getObjectiveType()))
 				objective = true;
+			_save->getPathfinding()->invalidateTUCostCache(tiles[i]->getPosition());
+			invalidateVoxelCache(tiles[i]->getPosition());
 			currentpart =  currentpart2;
 			if (tiles[i]->getMapData(currentpart)) // take new values
 			{
@@ -3167,6 +3638,30 @@ Tile *TileEngine::checkForTerrainExplosions()
 	return 0;
 }
 
+/**
+ * Checks for all chained explosions at once.
+ *
+ * All tiles that are ready to explode form one wave, that can be resolved together
+ * without searching the whole map again after each explosion.
+ * @param wave List of tiles on which a explosion occurred.
+ */
+void TileEngine::checkForTerrainExplosions(std::vector<Tile*> &wave)
+{
+	wave.clear();
+	if (_save->isPreview())
+	{
+		return;
+	}
+
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		if (_save->getTile(i)->getExplosive())
+		{
+			wave.push_back(_save->getTile(i));
+		}
+	}
+}
+
 /**
  * Calculates the amount of power that is blocked going from one tile to another on a different level.
  * @param startTile The tile where the power starts.
@@ -3661,6 +4156,8 @@ int TileEngine::unitOpensDoor(BattleUnit *unit, bool rClick, int dir)
 					if (door != -1)
 					{
 						part = i->second;
+						_save->getPathfinding()->invalidateTUCostCache(tile->getPosition());
+						invalidateVoxelCache(tile->getPosition());
 						if (door == 0)
 						{
 							++doorsOpened;
@@ -3734,6 +4231,7 @@ std::pair<int, Position> TileEngine::checkAdjacentDoors(Position pos, TilePart p
 			int doorAdj = tile->openDoor(part);
 			if (doorAdj == 1) //only expecting ufo doors
 			{
+				invalidateVoxelCache(tile->getPosition());
 				adjacentDoorsOpened++;
 				doorOffset++;
 			}
@@ -3749,6 +4247,7 @@ std::pair<int, Position> TileEngine::checkAdjacentDoors(Position pos, TilePart p
 			int doorAdj = tile->openDoor(part);
 			if (doorAdj == 1)
 			{
+				invalidateVoxelCache(tile->getPosition());
 				adjacentDoorsOpened++;
 				doorOffset--;
 			}
@@ -3782,7 +4281,12 @@ int TileEngine::closeUfoDoors()
 				continue;
 			}
 		}
-		doorsclosed += _save->getTile(i)->closeUfoDoor();
+		if (_save->getTile(i)->closeUfoDoor())
+		{
+			++doorsclosed;
+			_save->getPathfinding()->invalidateTUCostCache(_save->getTile(i)->getPosition());
+			invalidateVoxelCache(_save->getTile(i)->getPosition());
+		}
 	}
 
 	return doorsclosed;
@@ -3851,6 +4355,14 @@ int TileEngine::calculateLineTile(Position origin, Position target, std::vector<
  * @return the objectnumber(0-3) or unit(4) or out of map (5) or -1(hit nothing).
  */
 VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible)
+{
+	return calculateLineVoxelImpl(_voxelCheckCache, origin, target, storeTrajectory, trajectory, excludeUnit, excludeAllBut, onlyVisible);
+}
+
+/**
+ * Calculates a line trajectory, using given voxel check cache.
+ */
+VoxelType TileEngine::calculateLineVoxelImpl(VoxelCheckCache &cache, Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible)
 {
 	VoxelType result;
 	bool excludeAllUnits = false;
@@ -3867,7 +4379,7 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 				trajectory->push_back(point);
 			}
 
-			result = voxelCheck(point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
+			result = voxelCheckImpl(cache, point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
 			if (result != V_EMPTY)
 			{
 				if (trajectory)
@@ -3881,7 +4393,7 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 		[&](Position point)
 		{
 			//check for xy diagonal intermediate voxel step
-			result = voxelCheck(point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
+			result = voxelCheckImpl(cache, point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
 			if (result != V_EMPTY)
 			{
 				if (trajectory != 0)
@@ -4020,6 +4532,14 @@ bool TileEngine::isVoxelVisible(Position voxel)
  * @return The objectnumber(0-3) or unit(4) or out of map (5) or -1 (hit nothing).
  */
 VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
+{
+	return voxelCheckImpl(_voxelCheckCache, voxel, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
+}
+
+/**
+ * Checks if we hit a voxel, using given cache of last checked tile.
+ */
+VoxelType TileEngine::voxelCheckImpl(VoxelCheckCache &cache, Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
 {
 	if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0) //preliminary out of map
 	{
@@ -4027,10 +4547,12 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 	}
 	Position pos = voxel.toTile();
 	Tile *tile, *tileBelow;
-	if (_cacheTilePos == pos)
+	const Uint16 *terrainVoxels;
+	if (cache.pos == pos)
 	{
-		tile = _cacheTile;
-		tileBelow = _cacheTileBelow;
+		tile = cache.tile;
+		tileBelow = cache.tileBelow;
+		terrainVoxels = cache.terrainVoxels;
 	}
 	else
 	{
@@ -4040,9 +4562,11 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 			return V_OUTOFBOUNDS; //not even cache
 		}
 		tileBelow = _save->getBelowTile(tile);
-		_cacheTilePos = pos;
-		_cacheTile = tile;
-		_cacheTileBelow = tileBelow;
+		terrainVoxels = getTerrainVoxels(_save->getTileIndex(pos));
+		cache.pos = pos;
+		cache.tile = tile;
+		cache.tileBelow = tileBelow;
+		cache.terrainVoxels = terrainVoxels;
  	}
 
 	if (tile->isVoid() && tile->getUnit() == 0 && (!tileBelow || tileBelow->getUnit() == 0))
@@ -4050,29 +4574,33 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 		return V_EMPTY;
 	}
 
-	if (tile->getMapData(O_FLOOR) && tile->getMapData(O_FLOOR)->isGravLift() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
+	// packed voxels tell if any part of terrain is there, only then we look which one it is
+	if (terrainVoxels && (terrainVoxels[((voxel.z%24)/2)*16 + voxel.y%16] & (1 << (15 - voxel.x%16))))
 	{
-		if ((tile->getPosition().z == 0) || (tileBelow && tileBelow->getMapData(O_FLOOR) && !tileBelow->getMapData(O_FLOOR)->isGravLift()))
+		if (tile->getMapData(O_FLOOR) && tile->getMapData(O_FLOOR)->isGravLift() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
 		{
-			return V_FLOOR;
+			if ((tile->getPosition().z == 0) || (tileBelow && tileBelow->getMapData(O_FLOOR) && !tileBelow->getMapData(O_FLOOR)->isGravLift()))
+			{
+				return V_FLOOR;
+			}
 		}
-	}
 
-	// first we check terrain voxel data, not to allow 2x2 units stick through walls
-	for (int i = V_FLOOR; i <= V_OBJECT; ++i)
-	{
-		TilePart tp = (TilePart)i;
-		MapData *mp = tile->getMapData(tp);
-		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
-			continue;
-		if (mp != 0)
+		// first we check terrain voxel data, not to allow 2x2 units stick through walls
+		for (int i = V_FLOOR; i <= V_OBJECT; ++i)
 		{
-			int x = 15 - voxel.x%16;
-			int y = voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if (_voxelData->at(idx) & (1 << x))
+			TilePart tp = (TilePart)i;
+			MapData *mp = tile->getMapData(tp);
+			if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+				continue;
+			if (mp != 0)
 			{
-				return (VoxelType)i;
+				int x = 15 - voxel.x%16;
+				int y = voxel.y%16;
+				int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
+				if (_voxelData->at(idx) & (1 << x))
+				{
+					return (VoxelType)i;
+				}
 			}
 		}
 	}
@@ -4121,9 +4649,121 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 
 void TileEngine::voxelCheckFlush()
 {
-	_cacheTilePos = invalid;
-	_cacheTile = 0;
-	_cacheTileBelow = 0;
+	_voxelCheckCache = VoxelCheckCache();
+}
+
+/**
+ * Gets packed terrain voxels of tile, all parts of the tile are merged into one bitmap.
+ * Tiles with same terrain share one bitmap, it is built lazily on first use.
+ * Gravity lift floors mark whole bottom layer, as it depends on the tile below.
+ * Other threads can call it only after `prepareTerrainVoxels`, as lazy build change shared tables.
+ * @param tileIndex Index of the tile.
+ * @return Rows of voxel bits, or null if tile does not have any terrain voxels.
+ */
+const Uint16 *TileEngine::getTerrainVoxels(int tileIndex)
+{
+	if (!Options::oxceVoxelTerrainCache)
+	{
+		return VoxelTerrainSolid.data();
+	}
+
+	Uint16 &id = _voxelTerrainIndex[tileIndex];
+	if (id == VoxelTerrainUnknown)
+	{
+		Tile *tile = _save->getTile(tileIndex);
+		VoxelTerrainShape shape = { };
+		bool empty = true;
+		for (int i = V_FLOOR; i <= V_OBJECT; ++i)
+		{
+			TilePart tp = (TilePart)i;
+			MapData *mp = tile->getMapData(tp);
+			if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+				continue;
+			if (mp != 0)
+			{
+				for (int layer = 0; layer < 12; ++layer)
+				{
+					int idx = mp->getLoftID(layer)*16;
+					for (int y = 0; y < 16; ++y)
+					{
+						shape[layer*16 + y] |= _voxelData->at(idx + y);
+						empty &= shape[layer*16 + y] == 0;
+					}
+				}
+				if (tp == O_FLOOR && mp->isGravLift())
+				{
+					std::fill_n(shape.begin(), 16, 0xFFFF);
+					empty = false;
+				}
+			}
+		}
+
+		if (empty)
+		{
+			id = VoxelTerrainEmpty;
+		}
+		else
+		{
+			auto it = _voxelTerrainShapeIds.find(shape);
+			if (it != _voxelTerrainShapeIds.end())
+			{
+				id = it->second;
+			}
+			else if (_voxelTerrainShapes.size() + 1 < VoxelTerrainSlow)
+			{
+				_voxelTerrainShapes.push_back(shape);
+				id = (Uint16)_voxelTerrainShapes.size();
+				_voxelTerrainShapeIds.insert(std::make_pair(shape, id));
+			}
+			else
+			{
+				// too many different tiles, check this one the slow way
+				id = VoxelTerrainSlow;
+			}
+		}
+	}
+
+	if (id == VoxelTerrainEmpty)
+	{
+		return nullptr;
+	}
+	if (id == VoxelTerrainSlow)
+	{
+		return VoxelTerrainSolid.data();
+	}
+	return _voxelTerrainShapes[id - 1].data();
+}
+
+/**
+ * Builds packed terrain voxels of all tiles that do not have them yet,
+ * after that `getTerrainVoxels` do not change anything and can be used by many threads.
+ * Need be called on main thread before any work is given to other threads.
+ */
+void TileEngine::prepareTerrainVoxels()
+{
+	if (_voxelTerrainComplete)
+	{
+		return;
+	}
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		getTerrainVoxels(i);
+	}
+	_voxelTerrainComplete = true;
+}
+
+/**
+ * Marks packed terrain voxels of tile for rebuild, need be called when any part of tile change.
+ * @param pos Position of the tile.
+ */
+void TileEngine::invalidateVoxelCache(Position pos)
+{
+	if (_save->getTile(pos))
+	{
+		_voxelTerrainIndex[_save->getTileIndex(pos)] = VoxelTerrainUnknown;
+		_voxelTerrainComplete = false;
+		voxelCheckFlush();
+	}
 }
 
 /**
@@ -4472,6 +5112,8 @@ bool TileEngine::hackObject(BattleAction& action, BattleObject* object)
 						currentPart2 = currentPart;
 					}
 					tile->switchToAltMCD(currentPart);
+					_save->getPathfinding()->invalidateTUCostCache(tile->getPosition());
+					invalidateVoxelCache(tile->getPosition());
 				}
 			}
 		}
@@ -18,6 +18,9 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <vector>
+#include <array>
+#include <deque>
+#include <map>
 #include "Position.h"
 #include "BattlescapeGame.h"
 #include "../Mod/RuleItem.h"
@@ -59,6 +62,10 @@ public:
 	static constexpr Position voxelTileSize = { Position::TileXY, Position::TileXY, Position::TileZ };
 	/// Half of size of tile in voxels
 	static constexpr Position voxelTileCenter = { Position::TileXY / 2, Position::TileXY / 2, Position::TileZ / 2 };
+	/// Number of rows in packed terrain voxels of one tile, 12 layers of 16 rows.
+	static constexpr int voxelTerrainRows = 12 * 16;
+	/// Largest radius of light tables, lights reaching further compute distances directly.
+	static constexpr int maxLightTableRadius = 64;
 
 private:
 	/**
@@ -73,6 +80,58 @@ private:
 		Uint8 height;
 	};
 
+	/**
+	 * Helper class storing last tile used by voxel check.
+	 */
+	struct VoxelCheckCache
+	{
+		Tile *tile = nullptr;
+		Tile *tileBelow = nullptr;
+		const Uint16 *terrainVoxels = nullptr;
+		Position pos = invalid;
+	};
+
+	/**
+	 * Packed terrain voxels of one tile, union of all tile parts.
+	 */
+	using VoxelTerrainShape = std::array<Uint16, voxelTerrainRows>;
+
+	/**
+	 * Node of tree made from all lines of sight of one eye, lines that start the same way share nodes.
+	 */
+	struct SightNode
+	{
+		/// Position relative to the eye.
+		Position pos;
+		/// Bounding box of ends of all lines going through this node.
+		Position targetMin, targetMax;
+		/// Direction and level change of step from parent node.
+		Sint8 dir, dz;
+		/// Some line ends in this node.
+		bool target;
+		int firstChild, childCount;
+	};
+
+	/**
+	 * Direction of one explosion ray.
+	 */
+	struct ExplosionRay
+	{
+		double sinTe, cosTe, sinFi, cosFi;
+		int te;
+	};
+
+	/**
+	 * Tile reached by explosion ray after some number of steps.
+	 */
+	struct ExplosionRayStep
+	{
+		/// Position relative to the center of explosion.
+		Position offset;
+		/// Ray is too close to edge of tile, position need be calculated from real center.
+		bool recalculate;
+	};
+
 	/**
 	 * Helper class storing reaction data.
 	 */
@@ -89,12 +148,25 @@ private:
 	SavedBattleGame *_save;
 	const std::vector<Uint16> *_voxelData;
 	std::vector<VisibilityBlockCache> _blockVisibility;
+	std::vector<Uint16> _voxelTerrainIndex;
+	std::deque<VoxelTerrainShape> _voxelTerrainShapes;
+	std::map<VoxelTerrainShape, Uint16> _voxelTerrainShapeIds;
+	std::vector<SightNode> _sightTrees[8 * 4];
+	std::vector<Uint16> _lightDistance;
+	std::vector<std::array<Uint8, 4>> _lightConeDirection;
+	int _lightTableRadius;
+	std::vector<ExplosionRay> _explosionRays;
+	std::vector<ExplosionRayStep> _explosionRaySteps;
+	int _explosionRayLength;
+	std::vector<int> _explosionDamage;
+	std::vector<Uint32> _explosionGeneration;
+	std::vector<int> _explosionTiles;
+	Uint32 _explosionCurrentGeneration;
 	RuleInventory *_inventorySlotGround;
 	constexpr static int heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12};
 	bool _personalLighting;
-	Tile *_cacheTile;
-	Tile *_cacheTileBelow;
-	Position _cacheTilePos;
+	VoxelCheckCache _voxelCheckCache;
+	bool _voxelTerrainComplete;
 	const int _maxViewDistance;        // 20 tiles by default
 	const int _maxViewDistanceSq;      // 20 * 20
 	const int _maxVoxelViewDistance;   // maxViewDistance * 16
@@ -106,8 +178,18 @@ private:
 	std::vector<BattleUnit*> _movingUnitPrev;
 	BattleUnit* _movingUnit = nullptr;
 
+	/// Gets index of offset from light source in light tables.
+	int getLightTableIndex(Position diff) const;
 	/// Add light source.
 	void addLight(MapSubset gs, Position center, int power, LightLayers layer, int coneSize = 0, int direction = 0);
+	/// Gets packed terrain voxels of tile.
+	const Uint16 *getTerrainVoxels(int tileIndex);
+	/// Checks what type of voxel occupies this space, using given cache.
+	VoxelType voxelCheckImpl(VoxelCheckCache &cache, Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut);
+	/// Calculates a line trajectory in voxel space, using given cache.
+	VoxelType calculateLineVoxelImpl(VoxelCheckCache &cache, Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible);
+	/// Checks validity for targetting a unit, using given cache.
+	bool canTargetUnitImpl(VoxelCheckCache &cache, Position *originVoxel, Tile *tile, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles, BattleUnit *potentialUnit);
 	/// Calculate blockage amount.
 	int blockage(Tile *tile, const TilePart part, ItemDamageType type, int direction = -1, bool checkingFromOrigin = false);
 	/// Get max distance that fire light can reach.
@@ -125,6 +207,15 @@ private:
 	/// Get threshold of darkness for LoS calculation.
 	int getMaxDarknessToSeeUnits() const { return _maxDarknessToSeeUnits; }
 
+	/// Gets tree of lines of sight for view direction and eye of large unit.
+	const std::vector<SightNode> &getSightTree(int direction, int eye);
+	/// Checks if any line of sight going through node ends inside of the map.
+	bool hasSightTarget(const std::vector<SightNode> &tree, int node, Position eye) const;
+	/// Adds tile to tiles visible by unit.
+	void addVisibleTile(BattleUnit *unit, Position pos);
+	/// Makes sure explosion rays are long enough for given radius.
+	void prepareExplosionRays(int maxRadius);
+
 	bool setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius);
 	inline bool inEventVisibilitySector(const Position &toCheck) const;
 
@@ -146,6 +237,19 @@ private:
 	/// Tries to perform a reaction snap shot to this location.
 	bool tryReaction(ReactionScore *reaction, BattleUnit *target, const BattleAction &originalAction);
 public:
+	/**
+	 * One line of fire check for `canTargetUnits`, same arguments as `canTargetUnit`.
+	 */
+	struct TargetUnitQuery
+	{
+		Position originVoxel;
+		Tile *tile;
+		Position scanVoxel;
+		BattleUnit *excludeUnit;
+		BattleUnit *potentialUnit;
+		bool result;
+	};
+
 	/// Creates a new TileEngine class.
 	TileEngine(SavedBattleGame *save, Mod *mod);
 	/// Cleans up the TileEngine.
@@ -176,13 +280,21 @@ public:
 	/// Handles bullet/weapon hits.
 	void hit(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, bool rangeAtack = true, int terrainMeleeTilePart = 0);
 	/// Handles explosions.
-	void explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack = true);
+	void explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack = true, bool updateView = true);
+	/// Updates lighting and visibility after explosions.
+	void updateExplosionView(Position min, Position max, int maxRadius);
 	/// Checks if a destroyed tile starts an explosion.
 	Tile *checkForTerrainExplosions();
+	/// Gets all tiles that start next wave of chained explosions.
+	void checkForTerrainExplosions(std::vector<Tile*> &wave);
 	/// Unit opens door?
 	int unitOpensDoor(BattleUnit *unit, bool rClick = false, int dir = -1);
 	/// Closes ufo doors.
 	int closeUfoDoors();
+	/// Marks packed terrain voxels of tile for rebuild.
+	void invalidateVoxelCache(Position pos);
+	/// Builds packed terrain voxels of all tiles.
+	void prepareTerrainVoxels();
 	/// Calculates a line trajectory in tile space.
 	int calculateLineTile(Position origin, Position target, std::vector<Position> &trajectory);
 	/// Calculates a line trajectory in voxel space.
@@ -253,6 +365,8 @@ public:
 	int checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit *excludeUnit, BattleUnit *excludeAllBut);
 	/// Checks validity for targetting a unit.
 	bool canTargetUnit(Position *originVoxel, Tile *tile, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles, BattleUnit *potentialUnit = 0);
+	/// Checks validity for targetting units for many queries at once.
+	void canTargetUnits(std::vector<TargetUnitQuery> &queries);
 	/// Check validity for targetting a tile.
 	bool canTargetTile(Position *originVoxel, Tile *tile, int part, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles);
 	/// Calculates the z voxel for shadows.
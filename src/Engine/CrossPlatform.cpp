@@ -26,6 +26,7 @@
 #include <fstream>
 #include <string>
 #include <list>
+#include <mutex>
 #include <stdint.h>
 #include <time.h>
 #include <signal.h>
@@ -1494,6 +1495,8 @@ static bool logToFile(const std::string& filename, const std::string& data) {
 static const size_t LOG_BUFFER_LIMIT = 1<<10;
 static std::list<std::pair<int, std::string>> logBuffer;
 static std::string logFileName;
+/// Log is written from AI and worker threads too.
+static std::mutex logMutex;
 const std::string& getLogFileName() { return logFileName; }
 
 /**
@@ -1505,6 +1508,7 @@ void setLogFileName(const std::string& name) {
 	deleteFile(name);
 	size_t sz = logBuffer.size();
 	Log(LOG_DEBUG) << "setLogFileName("<<name<<") was '"<<logFileName<<"'; "<<sz<<" in buffer";
+	std::lock_guard<std::mutex> lock(logMutex);
 	logFileName = name;
 }
 void log(int level, const std::ostringstream& baremsgstream) {
@@ -1514,6 +1518,7 @@ void log(int level, const std::ostringstream& baremsgstream) {
 			  << baremsgstream.str() << std::endl;
 	auto msg = msgstream.str();
 
+	std::lock_guard<std::mutex> lock(logMutex);
 	int effectiveLevel = Logger::reportingLevel();
 	if (effectiveLevel >= LOG_DEBUG) {
 		fwrite(msg.c_str(), msg.size(), 1, stderr);
@@ -41,6 +41,7 @@
 #include <istream>
 #include <unordered_map>
 #include <unordered_set>
+#include <mutex>
 
 #include "FileMap.h"
 #include "Unicode.h"
@@ -262,9 +263,18 @@ SDL_RWops *FileRecord::getRWopsReadAll() const
 	return rv;
 }
 
+namespace
+{
+
+/// Zip archive reader keeps its state, so only one file can be extracted at once.
+std::mutex zipMutex;
+
+}
+
 std::unique_ptr<std::istream> FileRecord::getIStream() const
 {
 	if (zip != NULL) {
+		std::unique_lock<std::mutex> lock(zipMutex);
 		size_t size;
 		void *data = mz_zip_reader_extract_to_heap((mz_zip_archive *)zip, findex, &size, 0);
 		if (data == NULL) {
@@ -295,6 +305,38 @@ YAML::Node FileRecord::getYAML() const
 	}
 }
 
+/**
+ * Parses the file the same way as getYAML(), but only throws on errors.
+ * Logger is not thread safe, so this is used when files are parsed on worker threads.
+ */
+YAML::Node FileRecord::getYAMLQuiet() const
+{
+	std::string content;
+	if (zip != NULL) {
+		std::unique_lock<std::mutex> lock(zipMutex);
+		size_t size;
+		void *data = mz_zip_reader_extract_to_heap((mz_zip_archive *)zip, findex, &size, 0);
+		if (data == NULL) {
+			throw Exception("failed to decompress " + fullpath);
+		}
+		content.assign((char *)data, size);
+		mz_free(data);
+	} else {
+		SDL_RWops *rwops = SDL_RWFromFile(fullpath.c_str(), "r");
+		if (!rwops) {
+			throw Exception("Failed to read " + fullpath);
+		}
+		size_t size;
+		char *data = (char *)SDL_LoadFile_RW(rwops, &size, SDL_TRUE);
+		if (data == NULL) {
+			throw Exception("Failed to read " + fullpath);
+		}
+		content.assign(data, size);
+		SDL_free(data);
+	}
+	return YAML::Load(content);
+}
+
 std::vector<YAML::Node> FileRecord::getAllYAML() const
 {
 	try
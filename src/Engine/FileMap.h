@@ -51,6 +51,8 @@ namespace FileMap
 
 		std::unique_ptr<std::istream> getIStream() const;
 		YAML::Node getYAML() const;
+		/// Parses file without logging errors, usable from worker threads.
+		YAML::Node getYAMLQuiet() const;
 		std::vector<YAML::Node> getAllYAML() const;
 	};
 
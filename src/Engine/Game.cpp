@@ -38,6 +38,7 @@
 #include "Exception.h"
 #include "Options.h"
 #include "CrossPlatform.h"
+#include "Script.h"
 #include "FileMap.h"
 #include "Unicode.h"
 #include "../Ufopaedia/UfopaediaStartState.h"
@@ -117,6 +118,11 @@ Game::~Game()
 	Sound::stop();
 	Music::stop();
 
+	if (Options::oxceScriptProfiler)
+	{
+		ScriptProfiler::report();
+	}
+
 	for (std::list<State*>::iterator i = _states.begin(); i != _states.end(); ++i)
 	{
 		delete *i;
@@ -306,6 +312,13 @@ void Game::run()
 								}
 							}
 						}
+						// "ctrl-p" script profile
+						else if (action.getDetails()->key.keysym.sym == SDLK_p && isCtrlPressed() && Options::oxceScriptProfiler)
+						{
+							ScriptProfiler::report();
+							// do not let states see plain "p"
+							continue;
+						}
 						else if (Options::debug)
 						{
 							if (action.getDetails()->key.keysym.sym == SDLK_t && isCtrlPressed())
@@ -243,6 +243,21 @@ void create()
 	_info.push_back(OptionInfo("oxceMaxEquipmentLayoutTemplates", &oxceMaxEquipmentLayoutTemplates, 20));
 	_info.push_back(OptionInfo("oxcePersonalLayoutIncludingArmor", &oxcePersonalLayoutIncludingArmor, true));
 	_info.push_back(OptionInfo("oxceManufactureFilterSuppliesOK", &oxceManufactureFilterSuppliesOK, false));
+	_info.push_back(OptionInfo("oxcePathfindingBucketQueue", &oxcePathfindingBucketQueue, true));
+	_info.push_back(OptionInfo("oxcePathfindingEdgeCache", &oxcePathfindingEdgeCache, true));
+	_info.push_back(OptionInfo("oxcePathfindingHierarchy", &oxcePathfindingHierarchy, false));
+	_info.push_back(OptionInfo("oxceVoxelTerrainCache", &oxceVoxelTerrainCache, true));
+	_info.push_back(OptionInfo("oxceSightTree", &oxceSightTree, true));
+	_info.push_back(OptionInfo("oxceLightTables", &oxceLightTables, true));
+	_info.push_back(OptionInfo("oxceExplosionWaves", &oxceExplosionWaves, true));
+	_info.push_back(OptionInfo("oxceBackgroundAI", &oxceBackgroundAI, true));
+	_info.push_back(OptionInfo("oxceDirtyRows", &oxceDirtyRows, true));
+	_info.push_back(OptionInfo("oxceScriptOptimizations", &oxceScriptOptimizations, true));
+	_info.push_back(OptionInfo("oxceBlitScriptCache", &oxceBlitScriptCache, true));
+	_info.push_back(OptionInfo("oxceScriptProfiler", &oxceScriptProfiler, false));
+	_info.push_back(OptionInfo("oxceParallelLineOfFire", &oxceParallelLineOfFire, true));
+	_info.push_back(OptionInfo("oxceParallelRulesetParsing", &oxceParallelRulesetParsing, true));
+	_info.push_back(OptionInfo("oxceThreads", &oxceThreads, 0)); // 0 = one per core
 	_info.push_back(OptionInfo("oxceTogglePersonalLightType", &oxceTogglePersonalLightType, 1)); // per battle
 	_info.push_back(OptionInfo("oxceToggleNightVisionType", &oxceToggleNightVisionType, 1));     // per battle
 	_info.push_back(OptionInfo("oxceToggleBrightnessType", &oxceToggleBrightnessType, 0));       // not persisted
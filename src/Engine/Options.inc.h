@@ -89,6 +89,21 @@ OPT bool oxceEnablePaletteFlickerFix;
 OPT int oxceMaxEquipmentLayoutTemplates;
 OPT bool oxcePersonalLayoutIncludingArmor;
 OPT bool oxceManufactureFilterSuppliesOK;
+OPT bool oxcePathfindingBucketQueue;
+OPT bool oxcePathfindingEdgeCache;
+OPT bool oxcePathfindingHierarchy;
+OPT bool oxceVoxelTerrainCache;
+OPT bool oxceSightTree;
+OPT bool oxceLightTables;
+OPT bool oxceExplosionWaves;
+OPT bool oxceBackgroundAI;
+OPT bool oxceDirtyRows;
+OPT bool oxceScriptOptimizations;
+OPT bool oxceBlitScriptCache;
+OPT bool oxceScriptProfiler;
+OPT bool oxceParallelLineOfFire;
+OPT bool oxceParallelRulesetParsing;
+OPT int oxceThreads;
 // 0 = not persisted; 1 = persisted per battle; 2 = persisted per campaign
 OPT int oxceTogglePersonalLightType;
 OPT int oxceToggleNightVisionType;
@@ -112,7 +112,7 @@ void Screen::makeVideoFlags()
  * Initializes a new display screen for the game to render contents to.
  * The screen is set up based on the current options.
  */
-Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _flickerFix(false)
+Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _flickerFix(false), _partialFlip(false), _fullFlip(true)
 {
 	_flickerFix = Options::oxceEnablePaletteFlickerFix;
 
@@ -201,13 +201,30 @@ void Screen::flip()
 		_pushPalette = false;
 	}
 
+	int firstRow = 0, lastRow = _surface->h;
+	bool partial = _partialFlip && getChangedRows(firstRow, lastRow);
+	if (partial)
+	{
+		if (firstRow == lastRow)
+		{
+			// nothing changed, display still shows this frame
+			return;
+		}
+		// filters look at neighbouring rows too
+		firstRow = std::max(firstRow - 2, 0);
+		lastRow = std::min(lastRow + 2, _surface->h);
+	}
+
+	SDL_Rect changed = {0, 0, (Uint16)_screen->w, (Uint16)_screen->h};
 	if (getWidth() != _baseWidth || getHeight() != _baseHeight || useOpenGL())
 	{
-		Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput);
+		changed = Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput, firstRow, lastRow);
 	}
 	else
 	{
-		SDL_BlitSurface(_surface.get(), 0, _screen, 0);
+		SDL_Rect rect = {0, (Sint16)firstRow, (Uint16)_surface->w, (Uint16)(lastRow - firstRow)};
+		SDL_BlitSurface(_surface.get(), &rect, _screen, &rect);
+		changed = rect;
 	}
 
 	// perform any requested palette update
@@ -223,7 +240,11 @@ void Screen::flip()
 
 
 
-	if (SDL_Flip(_screen) == -1)
+	if (partial)
+	{
+		SDL_UpdateRects(_screen, 1, &changed);
+	}
+	else if (SDL_Flip(_screen) == -1)
 	{
 		throw Exception(SDL_GetError());
 	}
@@ -231,11 +252,48 @@ void Screen::flip()
 
 /**
  * Clears all the contents out of the internal buffer.
+ * When only changed rows are flipped, the display keeps the last frame.
  */
 void Screen::clear()
 {
 	Surface::CleanSdlSurface(_surface.get());
-	Surface::CleanSdlSurface(_screen);
+	if (!_partialFlip)
+	{
+		Surface::CleanSdlSurface(_screen);
+	}
+}
+
+/**
+ * Compares the buffer with the copy of the last flipped frame
+ * and updates the copy.
+ * @param firstRow Returns first changed row.
+ * @param lastRow Returns row after last changed one.
+ * @return False if whole buffer must be flipped.
+ */
+bool Screen::getChangedRows(int &firstRow, int &lastRow)
+{
+	const Uint8 *pixels = (const Uint8*)_surface->pixels;
+	const size_t pitch = _surface->pitch;
+	const size_t size = pitch * _surface->h;
+	firstRow = 0;
+	lastRow = _surface->h;
+	if (_fullFlip || _lastFrame.size() != size)
+	{
+		_lastFrame.assign(pixels, pixels + size);
+		_fullFlip = false;
+		return false;
+	}
+
+	while (firstRow < lastRow && memcmp(pixels + firstRow * pitch, _lastFrame.data() + firstRow * pitch, pitch) == 0)
+	{
+		++firstRow;
+	}
+	while (lastRow > firstRow && memcmp(pixels + (lastRow - 1) * pitch, _lastFrame.data() + (lastRow - 1) * pitch, pitch) == 0)
+	{
+		--lastRow;
+	}
+	memcpy(_lastFrame.data() + firstRow * pitch, pixels + firstRow * pitch, (lastRow - firstRow) * pitch);
+	return true;
 }
 
 /**
@@ -263,6 +321,7 @@ void Screen::setPalette(const SDL_Color* colors, int firstcolor, int ncolors, bo
 	}
 
 	SDL_SetColors(_surface.get(), const_cast<SDL_Color *>(colors), firstcolor, ncolors);
+	_fullFlip = true;
 
 	// defer actual update of screen until SDL_Flip()
 	if (immediately && _screen->format->BitsPerPixel == 8 && SDL_SetColors(_screen, const_cast<SDL_Color *>(colors), firstcolor, ncolors) == 0)
@@ -328,6 +387,8 @@ void Screen::resetDisplay(bool resetVideo, bool noShaders)
 	Uint32 oldFlags = _flags;
 #endif
 	makeVideoFlags();
+	_partialFlip = false;
+	_fullFlip = true;
 
 	if (!_surface || (_surface->format->BitsPerPixel != _bpp ||
 		_surface->w != _baseWidth ||
@@ -392,6 +453,8 @@ void Screen::resetDisplay(bool resetVideo, bool noShaders)
 
 	Options::displayWidth = getWidth();
 	Options::displayHeight = getHeight();
+	// with real double buffering the back buffer doesn't keep the last frame
+	_partialFlip = Options::oxceDirtyRows && !useOpenGL() && !(_screen->flags & SDL_DOUBLEBUF);
 	_scaleX = getWidth() / (double)_baseWidth;
 	_scaleY = getHeight() / (double)_baseHeight;
 
@@ -19,6 +19,7 @@
  */
 #include <SDL.h>
 #include <string>
+#include <vector>
 #include "OpenGL.h"
 #include "Surface.h"
 
@@ -52,6 +53,10 @@ private:
 	OpenGL glOutput;
 	Surface::UniqueBufferPtr _buffer;
 	Surface::UniqueSurfacePtr _surface;
+	bool _partialFlip, _fullFlip;
+	std::vector<Uint8> _lastFrame;
+	/// Finds rows of the buffer that changed since last flip.
+	bool getChangedRows(int &firstRow, int &lastRow);
 	/// Sets the _flags and _bpp variables based on game options; needed in more than one place now
 	void makeVideoFlags();
 public:
@@ -24,6 +24,10 @@
 #include <cmath>
 #include <bitset>
 #include <array>
+#include <chrono>
+#include <mutex>
+#include <iterator>
+#include <limits>
 
 #include "Logger.h"
 #include "Options.h"
@@ -33,6 +37,7 @@
 #include "ShaderDraw.h"
 #include "ShaderMove.h"
 #include "Exception.h"
+#include "CrossPlatform.h"
 #include "../fallthrough.h"
 #include "Collections.h"
 
@@ -65,6 +70,17 @@ namespace OpenXcom
 	MACRO_COPY_64(Func, (Pos) + 0x80) \
 	MACRO_COPY_64(Func, (Pos) + 0xC0)
 
+#define MACRO_HEX_16(Func, High) \
+	Func(High##0) Func(High##1) Func(High##2) Func(High##3) \
+	Func(High##4) Func(High##5) Func(High##6) Func(High##7) \
+	Func(High##8) Func(High##9) Func(High##A) Func(High##B) \
+	Func(High##C) Func(High##D) Func(High##E) Func(High##F)
+#define MACRO_HEX_256(Func) \
+	MACRO_HEX_16(Func, 0x0) MACRO_HEX_16(Func, 0x1) MACRO_HEX_16(Func, 0x2) MACRO_HEX_16(Func, 0x3) \
+	MACRO_HEX_16(Func, 0x4) MACRO_HEX_16(Func, 0x5) MACRO_HEX_16(Func, 0x6) MACRO_HEX_16(Func, 0x7) \
+	MACRO_HEX_16(Func, 0x8) MACRO_HEX_16(Func, 0x9) MACRO_HEX_16(Func, 0xA) MACRO_HEX_16(Func, 0xB) \
+	MACRO_HEX_16(Func, 0xC) MACRO_HEX_16(Func, 0xD) MACRO_HEX_16(Func, 0xE) MACRO_HEX_16(Func, 0xF)
+
 
 ////////////////////////////////////////////////////////////
 //						proc definition
@@ -382,20 +398,23 @@ enum ProcEnum : Uint8
 
 /**
  * Core function in script engine used to executing scripts
+ * @tparam Profile count executed operations.
  * @param proc array storing operation of script
- * @return Result of executing script
+ * @return Number of executed operations, or zero if not counted.
  */
-static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
+template<bool Profile>
+static inline Uint64 scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 {
 	ProgPos curr = ProgPos::Start;
+	Uint64 ops = 0;
 	//--------------------------------------------------
 	//			helper macros for this function
 	//--------------------------------------------------
 	#define MACRO_FUNC_ARRAY(NAME, ...) + helper::FuncGroup<MACRO_FUNC_ID(NAME)>::FuncList{}
-	#define MACRO_FUNC_ARRAY_LOOP(POS) \
-		case (POS): \
+	#define MACRO_FUNC_ARRAY_BODY(POS) \
 		{ \
 			using currType = helper::GetType<func, POS>; \
+			if (Profile) ++ops; \
 			const auto p = proc + (int)curr; \
 			curr += currType::offset; \
 			const auto ret = currType::func(data, p, curr); \
@@ -409,13 +428,34 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 					goto errorLabel; \
 				} \
 			} \
-			else \
-				continue; \
 		}
+#ifdef __GNUC__
+	// each operation jumps directly to the next one, without going back to a single shared jump
+	#define MACRO_FUNC_ARRAY_LABEL(POS) &&MACRO_FUNC_ARRAY_LABEL_NAME(POS),
+	#define MACRO_FUNC_ARRAY_LABEL_NAME(POS) opLabel_##POS
+	#define MACRO_FUNC_ARRAY_LOOP(POS) \
+		MACRO_FUNC_ARRAY_LABEL_NAME(POS): \
+		MACRO_FUNC_ARRAY_BODY(POS) \
+		goto *labels[proc[(int)curr++]];
+#else
+	#define MACRO_FUNC_ARRAY_LOOP(POS) \
+		case (POS): \
+		MACRO_FUNC_ARRAY_BODY(POS) \
+		continue;
+#endif
 	//--------------------------------------------------
 
 	using func = decltype(MACRO_PROC_DEFINITION(MACRO_FUNC_ARRAY));
 
+#ifdef __GNUC__
+	static const void* const labels[256] =
+	{
+		MACRO_HEX_256(MACRO_FUNC_ARRAY_LABEL)
+	};
+
+	goto *labels[proc[(int)curr++]];
+	MACRO_HEX_256(MACRO_FUNC_ARRAY_LOOP)
+#else
 	while (true)
 	{
 		switch (proc[(int)curr++])
@@ -423,11 +463,17 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 		MACRO_COPY_256(MACRO_FUNC_ARRAY_LOOP, 0)
 		}
 	}
+#endif
 
 	//--------------------------------------------------
 	//			removing helper macros
 	//--------------------------------------------------
+#ifdef __GNUC__
+	#undef MACRO_FUNC_ARRAY_LABEL_NAME
+	#undef MACRO_FUNC_ARRAY_LABEL
+#endif
 	#undef MACRO_FUNC_ARRAY_LOOP
+	#undef MACRO_FUNC_ARRAY_BODY
 	#undef MACRO_FUNC_ARRAY
 	//--------------------------------------------------
 
@@ -439,7 +485,7 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 	}
 
 	endLabel:
-	return;
+	return ops;
 }
 
 
@@ -447,6 +493,93 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 //						Script class
 ////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/**
+ * Results of blit script for pairs of source and destination pixels.
+ * Script arguments other than pixels do not change during one blit and script can't change game state,
+ * so result for the same pair of pixels is always the same and is calculated only once per blit.
+ * Scripts that do not read destination pixel have one result for each source pixel.
+ */
+struct BlitScriptCache
+{
+	/// Number of blit for which value was calculated.
+	std::array<Uint32, 256 * 256> stamps = { };
+	/// Script results.
+	std::array<Uint8, 256 * 256> values = { };
+	/// Number of blit for which value of source pixel was calculated.
+	std::array<Uint32, 256> sourceStamps = { };
+	/// Script results for source pixels, `sourceKeep` if destination pixel should stay.
+	std::array<Uint16, 256> sourceValues = { };
+	static constexpr Uint16 sourceKeep = 0x100;
+	/// Number of current blit.
+	Uint32 stamp = 0;
+	/// Statistics for debug log.
+	Uint64 hits = 0, misses = 0;
+	int blits = 0;
+
+	/// Starts new blit, all old values are forgotten.
+	void next()
+	{
+		if (++stamp == 0)
+		{
+			stamps.fill(0);
+			sourceStamps.fill(0);
+			stamp = 1;
+		}
+		if (++blits == 10000)
+		{
+			if (hits + misses)
+			{
+				Log(LOG_DEBUG) << "Blit script cache: " << (hits * 100 / (hits + misses)) << "% of " << (hits + misses) << " pixels reused";
+			}
+			hits = 0;
+			misses = 0;
+			blits = 0;
+		}
+	}
+
+	/// Gets script result for pair of pixels, calls function only if not know yet.
+	template<typename Func>
+	Uint8 get(Uint8 src, Uint8 dest, Func&& f)
+	{
+		const int index = src * 256 + dest;
+		if (stamps[index] != stamp)
+		{
+			++misses;
+			stamps[index] = stamp;
+			values[index] = f();
+		}
+		else
+		{
+			++hits;
+		}
+		return values[index];
+	}
+
+	/// Gets script result for source pixel, calls function only if not know yet.
+	template<typename Func>
+	Uint16 getSource(Uint8 src, Func&& f)
+	{
+		if (sourceStamps[src] != stamp)
+		{
+			++misses;
+			sourceStamps[src] = stamp;
+			sourceValues[src] = f();
+		}
+		else
+		{
+			++hits;
+		}
+		return sourceValues[src];
+	}
+};
+
+thread_local BlitScriptCache blitScriptCache;
+
+}
+
 void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade)
 {
 	executeBlit(src, dest, x, y, shade, GraphSubset{ dest->getWidth(), dest->getHeight() } );
@@ -467,6 +600,56 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 
 	if (_proc)
 	{
+		const bool useCache = Options::oxceBlitScriptCache;
+		if (useCache)
+		{
+			blitScriptCache.next();
+		}
+		// each script used by blit (main and global events) is recorded once per blit under its own id
+		struct ProfileTotal { int id; Uint64 time; Uint64 ops; };
+		std::vector<ProfileTotal> profileTotals;
+		auto exe = [&](const Uint8* proc, int profileId)
+		{
+			if (profileId >= 0)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				const auto ops = scriptExe<true>(*this, proc);
+				const Uint64 time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+				auto total = std::find_if(profileTotals.begin(), profileTotals.end(), [&](const ProfileTotal& t) { return t.id == profileId; });
+				if (total == profileTotals.end())
+				{
+					profileTotals.push_back(ProfileTotal{ profileId, time, ops });
+				}
+				else
+				{
+					total->time += time;
+					total->ops += ops;
+				}
+			}
+			else
+			{
+				scriptExe<false>(*this, proc);
+			}
+		};
+		// `f` returns raw script result, zero means that destination pixel stays
+		auto cached = [&](Uint8 srcStuff, Uint8 destStuff, auto&& f) -> Uint8
+		{
+			if (!useCache)
+			{
+				const int result = f();
+				return result ? result : destStuff;
+			}
+			else if (_destUsed)
+			{
+				return blitScriptCache.get(srcStuff, destStuff, [&]() -> Uint8 { const int result = f(); return result ? result : destStuff; });
+			}
+			else
+			{
+				const Uint16 value = blitScriptCache.getSource(srcStuff, [&]() -> Uint16 { const int result = f(); return result ? (Uint8)result : BlitScriptCache::sourceKeep; });
+				return value == BlitScriptCache::sourceKeep ? destStuff : (Uint8)value;
+			}
+		};
+
 		if (_events)
 		{
 			ShaderDrawFunc(
@@ -474,30 +657,33 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 				{
 					if (srcStuff)
 					{
-						ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
-						set(arg);
-						auto ptr = _events;
-						while (*ptr)
+						destStuff = cached(srcStuff, destStuff, [&]() -> int
 						{
-							reset(arg);
-							scriptExe(*this, ptr->data());
+							ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
+							set(arg);
+							auto ptr = _events;
+							while (*ptr)
+							{
+								reset(arg);
+								exe(ptr->data(), ptr->getProfileId());
+								++ptr;
+							}
 							++ptr;
-						}
-						++ptr;
 
-						reset(arg);
-						scriptExe(*this, _proc);
-
-						while (*ptr)
-						{
 							reset(arg);
-							scriptExe(*this, ptr->data());
+							exe(_proc, _profileId);
+
+							while (*ptr)
+							{
+								reset(arg);
+								exe(ptr->data(), ptr->getProfileId());
+								++ptr;
+							}
 							++ptr;
-						}
-						++ptr;
 
-						get(arg);
-						if (arg.getFirst()) destStuff = arg.getFirst();
+							get(arg);
+							return arg.getFirst();
+						});
 					}
 				},
 				destShader,
@@ -511,17 +697,25 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 				{
 					if (srcStuff)
 					{
-						ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
-						set(arg);
-						scriptExe(*this, _proc);
-						get(arg);
-						if (arg.getFirst()) destStuff = arg.getFirst();
+						destStuff = cached(srcStuff, destStuff, [&]() -> int
+						{
+							ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
+							set(arg);
+							exe(_proc, _profileId);
+							get(arg);
+							return arg.getFirst();
+						});
 					}
 				},
 				destShader,
 				srcShader
 			);
 		}
+
+		for (const auto& total : profileTotals)
+		{
+			ScriptProfiler::record(total.id, total.time, total.ops);
+		}
 	}
 	else
 	{
@@ -531,13 +725,23 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 
 /**
  * Execute script with two arguments.
- * @return Result value from script.
+ * @param proc Script code.
+ * @param profileId Id of script in ScriptProfiler, negative if not profiled.
  */
-void ScriptWorkerBase::executeBase(const Uint8* proc)
+void ScriptWorkerBase::executeBase(const Uint8* proc, int profileId)
 {
 	if (proc)
 	{
-		scriptExe(*this, proc);
+		if (profileId >= 0)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const auto ops = scriptExe<true>(*this, proc);
+			ScriptProfiler::record(profileId, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), ops);
+		}
+		else
+		{
+			scriptExe<false>(*this, proc);
+		}
 	}
 }
 
@@ -780,6 +984,171 @@ bool callOverloadProc(ParserWriter& ph, const ScriptRange<ScriptProcData>& proc,
 	}
 }
 
+/**
+ * Helper computing arithmetic operation on values known during parsing.
+ * @param op Name of operation.
+ * @param reg Value of first argument, updated by operation.
+ * @param data Values of rest of arguments.
+ * @param dataSize Number of rest of arguments.
+ * @return false if operation is unknown or its result can't be computed now (like division by zero).
+ */
+bool foldConstOperation(ScriptRef op, int& reg, const int* data, size_t dataSize)
+{
+	auto is = [&](const char* name, size_t size)
+	{
+		return op == ScriptRef{ name } && dataSize == size;
+	};
+	// unsigned math wraps around same as operations do when script runs, without undefined behavior in parser
+	auto u = [](int i)
+	{
+		return static_cast<unsigned>(i);
+	};
+
+	if (is("set", 1))
+	{
+		reg = data[0];
+	}
+	else if (is("clear", 0))
+	{
+		reg = 0;
+	}
+	else if (is("add", 1))
+	{
+		reg = static_cast<int>(u(reg) + u(data[0]));
+	}
+	else if (is("sub", 1))
+	{
+		reg = static_cast<int>(u(reg) - u(data[0]));
+	}
+	else if (is("mul", 1))
+	{
+		reg = static_cast<int>(u(reg) * u(data[0]));
+	}
+	else if (is("aggregate", 2))
+	{
+		reg = static_cast<int>(u(reg) + u(data[0]) * u(data[1]));
+	}
+	else if (is("offset", 2))
+	{
+		reg = static_cast<int>(u(reg) * u(data[0]) + u(data[1]));
+	}
+	else if (is("div", 1) || is("mod", 1))
+	{
+		if (data[0] == 0 || (data[0] == -1 && reg == std::numeric_limits<int>::min()))
+		{
+			return false;
+		}
+		reg = op == ScriptRef{ "div" } ? reg / data[0] : reg % data[0];
+	}
+	else if (is("shl", 1) || is("shr", 1))
+	{
+		if (data[0] < 0 || data[0] >= 32)
+		{
+			return false;
+		}
+		reg = op == ScriptRef{ "shl" } ? static_cast<int>(u(reg) << data[0]) : reg >> data[0];
+	}
+	else if (is("bit_and", 1))
+	{
+		reg = reg & data[0];
+	}
+	else if (is("bit_or", 1))
+	{
+		reg = reg | data[0];
+	}
+	else if (is("bit_xor", 1))
+	{
+		reg = reg ^ data[0];
+	}
+	else if (is("bit_not", 0))
+	{
+		reg = ~reg;
+	}
+	else if (is("limit", 2))
+	{
+		reg = std::max(std::min(reg, data[1]), data[0]);
+	}
+	else if (is("limit_upper", 1))
+	{
+		reg = std::min(reg, data[0]);
+	}
+	else if (is("limit_lower", 1))
+	{
+		reg = std::max(reg, data[0]);
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Helper computing operation on int variable during parsing, when all its arguments are known.
+ * Result is stored by `set`, and when nothing used variable after previous `set`, that one is updated instead.
+ * This way chains like `set x 2; mul x 3; add x 1;` end as one `set x 7;`.
+ * @return true if operation was handled, false if it need be parsed normally.
+ */
+bool parseConstOperation(ParserWriter& ph, ScriptRef op, const ScriptRefData* begin, const ScriptRefData* end)
+{
+	if (begin == end || !ArgIsVar(begin->type) || ArgBase(begin->type) != ArgInt || ArgIsPtr(begin->type) || !begin->isValueType<RegEnum>())
+	{
+		return false;
+	}
+
+	int data[ScriptMaxArg] = { };
+	size_t dataSize = 0;
+	for (auto it = begin + 1; it != end; ++it)
+	{
+		if (!ph.getConstValue(*it, data[dataSize++]))
+		{
+			return false;
+		}
+	}
+
+	int value = 0;
+	const bool known = ph.getConstValue(*begin, value);
+	if (!known && op != ScriptRef{ "set" } && op != ScriptRef{ "clear" })
+	{
+		return false;
+	}
+	if (!foldConstOperation(op, value, data, dataSize))
+	{
+		return false;
+	}
+
+	const auto reg = static_cast<size_t>(begin->getValue<RegEnum>());
+	if (ph.regConst.size() <= reg)
+	{
+		ph.regConst.resize(reg + 1);
+	}
+	auto& regConst = ph.regConst[reg];
+	if (regConst.setValuePos != ProgPos::Unknown)
+	{
+		// old value was never read, we can replace it
+		ph.update(regConst.setValuePos, &value, sizeof(value));
+		regConst.value = value;
+		return true;
+	}
+
+	const ScriptRefData setArgs[] = { *begin, ScriptRefData{ begin->name, ArgInt, value } };
+	const auto setBegin = ph.getCurrPos();
+	if (callOverloadProc(ph, ph.parser.getProc(ScriptRef{ "set" }), std::begin(setArgs), std::end(setArgs)) == false)
+	{
+		return false;
+	}
+	const auto setEnd = ph.getCurrPos();
+
+	regConst.known = true;
+	regConst.value = value;
+	// operation id, register and value
+	if (ph.getDiffPos(setBegin, setEnd) == sizeof(Uint8) + sizeof(Uint8) + sizeof(int))
+	{
+		regConst.setValuePos = static_cast<ProgPos>(static_cast<size_t>(setEnd) - sizeof(int));
+	}
+	return true;
+}
+
 
 ////////////////////////////////////////////////////////////
 //			Pushing operation on proc vector
@@ -907,6 +1276,16 @@ bool parseConditionImpl(ParserWriter& ph, ScriptRefData truePos, ScriptRefData f
 		return false;
 	}
 
+	// both sides are known now, there is no need to compare them every time script runs
+	int a = 0;
+	int b = 0;
+	if (Options::oxceScriptOptimizations && ph.getConstValue(conditionArgs[0], a) && ph.getConstValue(conditionArgs[1], b))
+	{
+		const auto result = equalFunc ? (a == b) : (a <= b);
+		ph.pushProc(Proc_goto);
+		return ph.pushLabelTry(result ? conditionArgs[2] : conditionArgs[3]);
+	}
+
 	const auto proc = ph.parser.getProc(ScriptRef{ equalFunc ? "test_eq" : "test_le" });
 	if (callOverloadProc(ph, proc, std::begin(conditionArgs), std::end(conditionArgs)) == false)
 	{
@@ -2047,6 +2426,15 @@ ParserWriter::ParserWriter(
 void ParserWriter::relese()
 {
 	pushProc(Proc_exit);
+
+	for (Uint8 i = 0; i < parser.getParamSize(); ++i)
+	{
+		const auto reg = static_cast<Uint8>(parser.getParamData(i)->getValue<RegEnum>());
+		if (i < 64 && reg < regUsed.size() && regUsed[reg])
+		{
+			container._paramUsed |= (Uint64)1 << i;
+		}
+	}
 	refLabels.forEachPosition(
 		[&](auto pos, ProgPos value)
 		{
@@ -2058,6 +2446,25 @@ void ParserWriter::relese()
 		}
 	);
 
+	// jumps that land on `goto` can go directly to its destination, `if` and `else` nested in other blocks create lot of them
+	auto readPos = [&](ProgPos pos)
+	{
+		ProgPos value;
+		memcpy(&value, &container._proc[static_cast<size_t>(pos)], sizeof(ProgPos));
+		return value;
+	};
+	refLabels.forEachPosition(
+		[&](auto pos, ProgPos value)
+		{
+			// limit protects from loops made only from `goto`
+			for (int i = 0; i < 64 && Options::oxceScriptOptimizations && container._proc[static_cast<size_t>(value)] == Proc_goto; ++i)
+			{
+				value = readPos(static_cast<ProgPos>(static_cast<size_t>(value) + 1));
+			}
+			updateReserved<ProgPos>(pos, value);
+		}
+	);
+
 	auto textTotalSize = 0u;
 	refTexts.forEachPosition(
 		[&](auto pos, ScriptRef value)
@@ -2323,12 +2730,67 @@ bool ParserWriter::pushRegTry(const ScriptRefData& data, ArgEnum type)
 	type = ArgSpecAdd(type, ArgSpecReg);
 	if (data && ArgCompatible(type, data.type, 0) && data.getValue<RegEnum>() != RegInvalid)
 	{
-		pushValue(static_cast<Uint8>(data.getValue<RegEnum>()));
+		const auto reg = static_cast<Uint8>(data.getValue<RegEnum>());
+		if (regUsed.size() <= reg)
+		{
+			regUsed.resize(reg + 1);
+		}
+		regUsed[reg] = true;
+		pushValue(reg);
 		return true;
 	}
 	return false;
 }
 
+/**
+ * Get int value of arg if it is known during parsing.
+ * @param data Constant or register.
+ * @param value Output value.
+ * @return true if value is known.
+ */
+bool ParserWriter::getConstValue(const ScriptRefData& data, int& value) const
+{
+	if (data.type == ArgInt && data.isValueType<int>())
+	{
+		value = data.getValue<int>();
+		return true;
+	}
+	if (ArgIsReg(data.type) && ArgBase(data.type) == ArgInt && !ArgIsPtr(data.type) && data.isValueType<RegEnum>())
+	{
+		const auto reg = static_cast<size_t>(data.getValue<RegEnum>());
+		if (reg < regConst.size() && regConst[reg].known)
+		{
+			value = regConst[reg].value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Forget known value of reg arg, needed when operation could read or change it.
+ * @param data Any arg of operation.
+ */
+void ParserWriter::forgetConst(const ScriptRefData& data)
+{
+	if (ArgIsReg(data.type) && data.isValueType<RegEnum>())
+	{
+		const auto reg = static_cast<size_t>(data.getValue<RegEnum>());
+		if (reg < regConst.size())
+		{
+			regConst[reg] = RegConst{ };
+		}
+	}
+}
+
+/**
+ * Forget known values of all regs, needed when code can be reached by jump.
+ */
+void ParserWriter::forgetConst()
+{
+	regConst.clear();
+}
+
 /**
  * Add new reg arg definition.
  * @param s optional name of reg
@@ -2814,6 +3276,10 @@ bool ScriptParserBase::parseBase(ScriptContainerBase& destScript, const std::str
 				return false;
 			}
 			help.relese();
+			if (Options::oxceScriptProfiler)
+			{
+				tempScript._profileId = ScriptProfiler::add(_name, parentName, getGlobal()->getCurrentModName());
+			}
 			destScript = std::move(tempScript);
 			return true;
 		}
@@ -2960,12 +3426,41 @@ bool ScriptParserBase::parseBase(ScriptContainerBase& destScript, const std::str
 			return false;
 		}
 
+		// values known before label are not valid when something jump to it, same with `else` condition or end of block
+		if (label || isEnd)
+		{
+			help.forgetConst();
+		}
+
+		// arithmetic on known values can be done now
+		if (Options::oxceScriptOptimizations && !isVarDef && parseConstOperation(help, op, argData, argData+i))
+		{
+			continue;
+		}
+
 		// create normal proc call
 		if (callOverloadProc(help, op_curr, argData, argData+i) == false)
 		{
 			Log(LOG_ERROR) << err << "invalid operation in line: '" << line.toString() << "'";
 			return false;
 		}
+
+		// blocks and loops jump around, any other operation can read or change its args
+		if (isVarDef || isBegin || isEnd || isBreak || isReturn)
+		{
+			help.forgetConst();
+		}
+		else
+		{
+			for (size_t j = 0; j < i; ++j)
+			{
+				if (argData[j].type == ArgLabel)
+				{
+					help.forgetConst();
+				}
+				help.forgetConst(argData[j]);
+			}
+		}
 	}
 }
 
@@ -3438,6 +3933,112 @@ void ScriptValuesBase::saveBase(YAML::Node &node, const ScriptGlobal* shared, Ar
 	}
 }
 
+////////////////////////////////////////////////////////////
+//					ScriptProfiler class
+////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/**
+ * Statistics of one script.
+ */
+struct ScriptProfileData
+{
+	std::string hook;
+	std::string parent;
+	std::string mod;
+	Uint64 calls = 0;
+	Uint64 time = 0;
+	Uint64 maxTime = 0;
+	Uint64 ops = 0;
+};
+
+/// All profiled scripts, scripts can run in AI thread too.
+std::mutex scriptProfileMutex;
+std::vector<ScriptProfileData> scriptProfileData;
+
+}
+
+/**
+ * Register new script.
+ * @param hook Name of script hook.
+ * @param parent Name of rule that script belongs to.
+ * @param mod Name of mod that defined script.
+ * @return Id used to record runs of script.
+ */
+int ScriptProfiler::add(const std::string& hook, const std::string& parent, const std::string& mod)
+{
+	std::lock_guard<std::mutex> lock(scriptProfileMutex);
+	ScriptProfileData data;
+	data.hook = hook;
+	data.parent = parent;
+	data.mod = mod;
+	scriptProfileData.push_back(data);
+	return (int)scriptProfileData.size() - 1;
+}
+
+/**
+ * Add one run of script.
+ * @param id Id of script.
+ * @param time Time of run in nanoseconds.
+ * @param ops Number of executed operations.
+ */
+void ScriptProfiler::record(int id, Uint64 time, Uint64 ops)
+{
+	std::lock_guard<std::mutex> lock(scriptProfileMutex);
+	auto& data = scriptProfileData[id];
+	data.calls += 1;
+	data.time += time;
+	data.maxTime = std::max(data.maxTime, time);
+	data.ops += ops;
+}
+
+/**
+ * Write statistics of all scripts that run at least once to log
+ * and to `scriptProfile.csv` in user folder, most expensive first.
+ */
+void ScriptProfiler::report()
+{
+	std::vector<ScriptProfileData> sorted;
+	{
+		std::lock_guard<std::mutex> lock(scriptProfileMutex);
+		std::copy_if(scriptProfileData.begin(), scriptProfileData.end(), std::back_inserter(sorted), [](const ScriptProfileData& d) { return d.calls > 0; });
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const ScriptProfileData& a, const ScriptProfileData& b) { return a.time > b.time; });
+
+	auto quote = [](const std::string& s)
+	{
+		std::string r = "\"";
+		for (char c : s)
+		{
+			if (c == '"') r += '"';
+			r += c;
+		}
+		return r + "\"";
+	};
+
+	std::ostringstream csv;
+	csv << "hook,parent,mod,calls,totalMs,avgUs,maxUs,ops\n";
+	Log(LOG_INFO) << "Script profile, " << sorted.size() << " scripts:";
+	for (const auto& d : sorted)
+	{
+		const double totalMs = d.time / 1000000.0;
+		const double avgUs = d.time / 1000.0 / d.calls;
+		const double maxUs = d.maxTime / 1000.0;
+		Log(LOG_INFO) << "  " << d.hook << " of '" << d.parent << "' from '" << d.mod << "': "
+			<< d.calls << " calls, " << totalMs << " ms total, " << avgUs << " us avg, " << maxUs << " us max, " << d.ops << " ops";
+		csv << quote(d.hook) << ',' << quote(d.parent) << ',' << quote(d.mod) << ','
+			<< d.calls << ',' << totalMs << ',' << avgUs << ',' << maxUs << ',' << d.ops << '\n';
+	}
+
+	const std::string filename = Options::getMasterUserFolder() + "scriptProfile.csv";
+	if (!CrossPlatform::writeFile(filename, csv.str()))
+	{
+		Log(LOG_ERROR) << "Failed to write script profile to " << filename;
+	}
+}
+
 ////////////////////////////////////////////////////////////
 //					ScriptGlobal class
 ////////////////////////////////////////////////////////////
@@ -3720,4 +4321,79 @@ void ScriptGlobal::load(const YAML::Node& node)
 	}
 }
 
+/**
+ * Parses test scripts with and without parse time optimizations and compares their results for different inputs.
+ * Scripts cover folding of constant arithmetic and conditions, merging of `set` chains and jumps threaded through nested blocks.
+ * @return true if all scripts give same results.
+ */
+bool ScriptGlobal::verifyOptimizations()
+{
+	using Parser = ScriptParser<ScriptOutputArgs<int&, int&>, int, int>;
+
+	const char* const scripts[] =
+	{
+		"set a 2; mul a 3; add a 1; return a b;",
+		"var int v; set v 7; set v 9; add v x; set a v; return a b;",
+		"var int v; set v x; add v 3; mul v 2; set a v; return a b;",
+		"var int v; set v 1; add b v; add v 1; add b v; set a v; return a b;",
+		"var int v; set v 4; shl v 2; bit_or v 1; bit_xor v 3; bit_and v 30; limit v 0 10; set b v; div v 3; mod v 2; aggregate v 3 4; offset v 2 1; limit_upper v 20; limit_lower v 5; bit_not v; sub a v; return a b;",
+		"var int v; set v 3; if eq v 3; add a 1; else; add a 2; end; add v 1; set b v; return a b;",
+		"var int v; set v 10; if lt x 0; set v 20; end; add v 1; set a v; return a b;",
+		"var int v; set v 1; if lt x 0; set v 2; else lt v 2; set v 3; end; set a v; return a b;",
+		"if lt x 0; if lt y 0; set a 1; else; set a 2; end; else; if gt y 0; set a 3; else; set a 4; end; end; return a b;",
+		"if gt 3 2; add a x; else; add a y; end; if eq 1 2; add b x; end; return a b;",
+		"var int v; loop var i 5; if eq i 2; continue; end; add v i; if gt v x; break; end; end; set a v; return a b;",
+		"set a 5; swap a b; add a 1; return a b;",
+	};
+	const int values[] = { -7, 0, 1, 5, 100 };
+
+	const bool oldOptimizations = Options::oxceScriptOptimizations;
+	const bool oldProfiler = Options::oxceScriptProfiler;
+	Options::oxceScriptProfiler = false;
+
+	ScriptGlobal global;
+	Parser parser(&global, "verifyOptimizations", "a", "b", "x", "y");
+
+	bool valid = true;
+	for (auto src : scripts)
+	{
+		Parser::Container optimized;
+		Parser::Container normal;
+		Options::oxceScriptOptimizations = true;
+		optimized.load("optimized", src, parser);
+		Options::oxceScriptOptimizations = false;
+		normal.load("normal", src, parser);
+		if (!optimized || !normal)
+		{
+			Log(LOG_ERROR) << "Test script for optimizations failed to parse: '" << src << "'";
+			valid = false;
+			continue;
+		}
+
+		auto sameResult = [&](int a, int b, int x, int y)
+		{
+			Parser::Output optimizedOutput{ a, b };
+			Parser::Output normalOutput{ a, b };
+			Parser::Worker{ x, y }.execute(optimized, optimizedOutput);
+			Parser::Worker{ x, y }.execute(normal, normalOutput);
+			if (optimizedOutput.data != normalOutput.data)
+			{
+				Log(LOG_ERROR) << "Script optimizations changed result of '" << src << "' for a=" << a << " b=" << b << " x=" << x << " y=" << y;
+				return false;
+			}
+			return true;
+		};
+		bool same = true;
+		for (int a : values) for (int b : values) for (int x : values) for (int y : values)
+		{
+			same = same && sameResult(a, b, x, y);
+		}
+		valid &= same;
+	}
+
+	Options::oxceScriptOptimizations = oldOptimizations;
+	Options::oxceScriptProfiler = oldProfiler;
+	return valid;
+}
+
 } //namespace OpenXcom
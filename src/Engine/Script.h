@@ -373,7 +373,12 @@ struct TypeInfo
 class ScriptContainerBase
 {
 	friend struct ParserWriter;
+	friend class ScriptParserBase;
 	std::vector<Uint8> _proc;
+	/// Bit mask of script parameters that are used by code.
+	Uint64 _paramUsed = 0;
+	/// Id in ScriptProfiler, negative if this script is not profiled.
+	int _profileId = -1;
 
 public:
 	/// Constructor.
@@ -402,6 +407,19 @@ public:
 	{
 		return *this ? _proc.data() : nullptr;
 	}
+
+	/// Test if script code uses given parameter.
+	bool isParamUsed(size_t i) const
+	{
+		// parameters that do not fit in mask are assumed to be used
+		return i >= 64 || ((_paramUsed >> i) & 1);
+	}
+
+	/// Get id of script in profiler.
+	int getProfileId() const
+	{
+		return _profileId;
+	}
 };
 
 /**
@@ -449,6 +467,37 @@ public:
 	{
 		return _events;
 	}
+	/// Get id of script in profiler.
+	int getProfileId() const
+	{
+		return _current.getProfileId();
+	}
+
+	/// Test if script code or any of global events uses given parameter.
+	bool isParamUsed(size_t i) const
+	{
+		if (_current.isParamUsed(i))
+		{
+			return true;
+		}
+		auto ptr = _events;
+		if (ptr)
+		{
+			// events before and after script code, each list ends with empty script
+			for (int list = 0; list < 2; ++list)
+			{
+				for (; *ptr; ++ptr)
+				{
+					if (ptr->isParamUsed(i))
+					{
+						return true;
+					}
+				}
+				++ptr;
+			}
+		}
+		return false;
+	}
 };
 
 /**
@@ -699,7 +748,7 @@ protected:
 	}
 
 	/// Call script.
-	void executeBase(const Uint8* proc);
+	void executeBase(const Uint8* proc, int profileId);
 
 public:
 	/// Default constructor.
@@ -758,7 +807,7 @@ public:
 		static_assert(std::is_same<typename Parent::Output, Output>::value, "Incompatible script output type");
 
 		set(arg);
-		executeBase(c.data());
+		executeBase(c.data(), c.getProfileId());
 		get(arg);
 	}
 
@@ -775,19 +824,19 @@ public:
 			while (*ptr)
 			{
 				reset(arg);
-				executeBase(ptr->data());
+				executeBase(ptr->data(), ptr->getProfileId());
 				++ptr;
 			}
 			++ptr;
 		}
 		reset(arg);
-		executeBase(c.data());
+		executeBase(c.data(), c.getProfileId());
 		if (ptr)
 		{
 			while (*ptr)
 			{
 				reset(arg);
-				executeBase(ptr->data());
+				executeBase(ptr->data(), ptr->getProfileId());
 				++ptr;
 			}
 		}
@@ -803,13 +852,17 @@ class ScriptWorkerBlit : public ScriptWorkerBase
 	/// Current script set in worker.
 	const Uint8* _proc;
 	const ScriptContainerBase* _events;
+	/// Current script reads destination pixel.
+	bool _destUsed;
+	/// Id of current script in profiler.
+	int _profileId;
 
 public:
 	/// Type of output value from script.
 	using Output = ScriptOutputArgs<int&, int>;
 
 	/// Default constructor.
-	ScriptWorkerBlit() : ScriptWorkerBase(), _proc(nullptr), _events(nullptr)
+	ScriptWorkerBlit() : ScriptWorkerBase(), _proc(nullptr), _events(nullptr), _destUsed(true), _profileId(-1)
 	{
 
 	}
@@ -824,6 +877,8 @@ public:
 		{
 			_proc = c.data();
 			_events = nullptr;
+			_destUsed = c.isParamUsed(1);
+			_profileId = c.getProfileId();
 			updateBase<Output>(args...);
 		}
 	}
@@ -838,6 +893,8 @@ public:
 		{
 			_proc = c.data();
 			_events = c.dataEvents();
+			_destUsed = c.isParamUsed(1);
+			_profileId = c.getProfileId();
 			updateBase<Output>(args...);
 		}
 	}
@@ -852,6 +909,8 @@ public:
 	{
 		_proc = nullptr;
 		_events = nullptr;
+		_destUsed = true;
+		_profileId = -1;
 	}
 };
 
@@ -1555,6 +1614,20 @@ struct ScriptTag
 	static constexpr ScriptTag getNullTag() { return make(0); }
 };
 
+/**
+ * Statistics of script runs for each hook and mod, collected only when `oxceScriptProfiler` option is on.
+ */
+class ScriptProfiler
+{
+public:
+	/// Register new script and get its id.
+	static int add(const std::string& hook, const std::string& parent, const std::string& mod);
+	/// Add one run of script.
+	static void record(int id, Uint64 time, Uint64 ops);
+	/// Write statistics to log and CSV file.
+	static void report();
+};
+
 /**
  * Global data shared by all scripts.
  */
@@ -1567,6 +1640,9 @@ protected:
 
 	friend class ScriptValuesBase;
 
+	/// Name of mod that is currently loaded.
+	std::string _currentModName;
+
 	struct TagValueType
 	{
 		ScriptRef name;
@@ -1696,6 +1772,10 @@ public:
 	virtual void beginLoad();
 	/// Finishing loading data.
 	virtual void endLoad();
+	/// Get name of mod that is currently loaded.
+	const std::string& getCurrentModName() const { return _currentModName; }
+	/// Check that parse time optimizations do not change results of test scripts.
+	static bool verifyOptimizations();
 
 	/// Load global data from YAML.
 	void load(const YAML::Node& node);
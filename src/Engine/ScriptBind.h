@@ -95,6 +95,17 @@ struct ParserWriter
 	/// Tag type representing position script operation id in proc vector.
 	class ProcOp { };
 
+	/// Value of int register known during parsing.
+	struct RegConst
+	{
+		/// Is value known.
+		bool known = false;
+		/// Current value.
+		int value = 0;
+		/// Position of value in last `set` of register, unknown if anything used register after it.
+		ProgPos setValuePos = ProgPos::Unknown;
+	};
+
 	/// List of all places in proc vector where we need have same values
 	template<typename T, typename CompType = T>
 	class ReservedCrossRefrenece
@@ -152,6 +163,10 @@ struct ParserWriter
 	ReservedCrossRefrenece<ProgPos> refLabels;
 	/// list of texts.
 	ReservedCrossRefrenece<ScriptText, ScriptRef> refTexts;
+	/// registers used by any operation.
+	std::vector<bool> regUsed;
+	/// values of registers known in current part of code without jumps.
+	std::vector<RegConst> regConst;
 
 	/// index of used script registers.
 	RegEnum regIndexUsed;
@@ -251,6 +266,13 @@ struct ParserWriter
 	/// Add new reg arg.
 	ScriptRefData addReg(const ScriptRef& s, ArgEnum type);
 
+	/// Get int value of arg if it is known during parsing.
+	bool getConstValue(const ScriptRefData& data, int& value) const;
+	/// Forget known value of reg arg.
+	void forgetConst(const ScriptRefData& data);
+	/// Forget known values of all regs.
+	void forgetConst();
+
 
 
 	/// Add new code scope.
@@ -19,6 +19,9 @@
  */
 #include "ShaderDrawHelper.h"
 #include <tuple>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace OpenXcom
 {
@@ -30,12 +33,12 @@ static inline First&& GetFirst(First&& f, Rest&&... r)
 }
 
 /**
- * Universal blit function implementation.
- * @param f called function.
+ * Universal blit function implementation, calls function once for every row.
+ * @param r called function, gets row size and all control objects set at start of row.
  * @param src source surfaces control objects.
  */
-template<typename Func, typename... SrcType>
-static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
+template<typename RowFunc, typename... SrcType>
+static inline void ShaderDrawRowsImpl(RowFunc&& r, helper::controler<SrcType>... src)
 {
 	//get basic draw range in 2d space
 	GraphSubset end_temp = GetFirst(src...).get_range();
@@ -76,28 +79,44 @@ static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
 		//set final iteration range
 		(src.set_x(begin_x, end_x), ...);
 
-		int size_x = end_x-begin_x;
-		//iteration on x-axis
-		for (int x = size_x / 4; x>0; --x)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
-		if (size_x & 2)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
-		if (size_x & 1)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
+		r(end_x-begin_x, src...);
 	}
 
 };
 
+/**
+ * Universal blit function implementation.
+ * @param f called function.
+ * @param src source surfaces control objects.
+ */
+template<typename Func, typename... SrcType>
+static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
+{
+	ShaderDrawRowsImpl(
+		[&f](int size_x, helper::controler<SrcType>&... src)
+		{
+			//iteration on x-axis
+			for (int x = size_x / 4; x>0; --x)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
+			if (size_x & 2)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
+			if (size_x & 1)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
+		},
+		src...
+	);
+};
+
 /**
  * Universal blit function.
  * @tparam ColorFunc class that contains static function `func`.
@@ -110,6 +129,19 @@ static inline void ShaderDraw(const SrcType&... src_frame)
 	ShaderDrawImpl([](auto&&... a){ ColorFunc::func(std::forward<decltype(a)>(a)...); }, helper::controler<SrcType>(src_frame)...);
 }
 
+/**
+ * Universal blit function that works on whole rows.
+ * @tparam ColorFunc class that contains static function `row`,
+ * it gets size of row and references to first pixel of row in every surface.
+ * Only surfaces with consecutive pixels in row (`ShaderMove`, `ShaderSurface`) and scalars can be used.
+ * @param src_frame destination and source surfaces modified by function.
+ */
+template<typename ColorFunc, typename... SrcType>
+static inline void ShaderDrawRow(const SrcType&... src_frame)
+{
+	ShaderDrawRowsImpl([](int size_x, auto&... a){ ColorFunc::row(size_x, a.get_ref()...); }, helper::controler<SrcType>(src_frame)...);
+}
+
 /**
  * Universal blit function.
  * @param f function that modify other arguments.
@@ -168,6 +200,44 @@ struct ColorReplace
 #endif
 	}
 
+	/**
+	* Function used by ShaderDrawRow in Surface::blitNShade
+	* set shade and replace color in whole row, same result as calling `func` for every pixel
+	* @param size number of pixels
+	* @param dest first destination pixel
+	* @param src first source pixel
+	* @param shade value of shade of this surface
+	* @param newColor new color to set (it should be offset by 4)
+	*/
+	static inline void row(int size, Uint8& dest, const Uint8& src, const int& shade, const int& newColor)
+	{
+		Uint8* d = &dest;
+		const Uint8* s = &src;
+		int x = 0;
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i group = _mm_set1_epi8((char)ColorGroup);
+		const __m128i black = _mm_set1_epi8((char)ColorShade);
+		const __m128i shadeV = _mm_set1_epi8((char)shade);
+		const __m128i colorV = _mm_set1_epi8((char)newColor);
+		for (; x + 16 <= size; x += 16)
+		{
+			const __m128i srcV = _mm_loadu_si128((const __m128i*)(s + x));
+			const __m128i destV = _mm_loadu_si128((const __m128i*)(d + x));
+			const __m128i newShade = _mm_add_epi8(_mm_and_si128(srcV, black), shadeV);
+			// all ones where pixel is so dark it would flip over to another color
+			const __m128i flip = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_and_si128(newShade, group), zero), _mm_cmpeq_epi8(zero, zero));
+			const __m128i n = _mm_or_si128(_mm_and_si128(flip, black), _mm_andnot_si128(flip, _mm_or_si128(colorV, newShade)));
+			const __m128i empty = _mm_cmpeq_epi8(srcV, zero);
+			_mm_storeu_si128((__m128i*)(d + x), _mm_or_si128(_mm_and_si128(empty, destV), _mm_andnot_si128(empty, n)));
+		}
+#endif
+		for (; x < size; ++x)
+		{
+			func(d[x], s[x], shade, newColor);
+		}
+	}
+
 };
 
 /**
@@ -212,6 +282,42 @@ struct StandardShade
 #endif
 	}
 
+	/**
+	* Function used by ShaderDrawRow in Surface::blitNShade
+	* set shade in whole row, same result as calling `func` for every pixel
+	* @param size number of pixels
+	* @param dest first destination pixel
+	* @param src first source pixel
+	* @param shade value of shade of this surface
+	*/
+	static inline void row(int size, Uint8& dest, const Uint8& src, const int& shade)
+	{
+		Uint8* d = &dest;
+		const Uint8* s = &src;
+		int x = 0;
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i group = _mm_set1_epi8((char)ColorGroup);
+		const __m128i black = _mm_set1_epi8((char)ColorShade);
+		const __m128i shadeV = _mm_set1_epi8((char)shade);
+		for (; x + 16 <= size; x += 16)
+		{
+			const __m128i srcV = _mm_loadu_si128((const __m128i*)(s + x));
+			const __m128i destV = _mm_loadu_si128((const __m128i*)(d + x));
+			const __m128i newShade = _mm_add_epi8(srcV, shadeV);
+			// all ones where pixel is so dark it would flip over to another color
+			const __m128i flip = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_and_si128(_mm_xor_si128(newShade, srcV), group), zero), _mm_cmpeq_epi8(zero, zero));
+			const __m128i n = _mm_or_si128(_mm_and_si128(flip, black), _mm_andnot_si128(flip, newShade));
+			const __m128i empty = _mm_cmpeq_epi8(srcV, zero);
+			_mm_storeu_si128((__m128i*)(d + x), _mm_or_si128(_mm_and_si128(empty, destV), _mm_andnot_si128(empty, n)));
+		}
+#endif
+		for (; x < size; ++x)
+		{
+			func(d[x], s[x], shade);
+		}
+	}
+
 };
 /**
  * helper class used for blitting dying unit with overkill
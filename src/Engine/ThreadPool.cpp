@@ -0,0 +1,179 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include "ThreadPool.h"
+#include "Options.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates pool and starts threads.
+ * @param threads Number of threads in addition to the calling one.
+ */
+ThreadPool::ThreadPool(int threads) : _task(nullptr), _taskCount(0), _nextTask(0), _finishedTasks(0), _generation(0), _quit(false)
+{
+	for (int i = 0; i < threads; ++i)
+	{
+		_threads.push_back(std::thread(&ThreadPool::work, this));
+	}
+}
+
+/**
+ * Stops and joins all threads.
+ */
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (auto& t : _threads)
+	{
+		t.join();
+	}
+}
+
+/**
+ * Gets the pool shared by all parts of the game.
+ * Size is taken from options when it is used for first time,
+ * zero means one thread for each core.
+ * @return Pool.
+ */
+ThreadPool &ThreadPool::getShared()
+{
+	static ThreadPool pool([]
+	{
+		int threads = Options::oxceThreads;
+		if (threads <= 0)
+		{
+			threads = (int)std::thread::hardware_concurrency();
+		}
+		return std::max(threads, 1) - 1;
+	}());
+	return pool;
+}
+
+/**
+ * Waits for work and helps with it.
+ */
+void ThreadPool::work()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	unsigned generation = _generation;
+	while (true)
+	{
+		_wake.wait(lock, [&]{ return _quit || _generation != generation; });
+		if (_quit)
+		{
+			return;
+		}
+		generation = _generation;
+		runTasks(lock);
+	}
+}
+
+/**
+ * Takes tasks one by one until all of them are taken.
+ * @param lock Lock of the pool mutex, released when task is running.
+ */
+void ThreadPool::runTasks(std::unique_lock<std::mutex> &lock)
+{
+	while (_task && _nextTask < _taskCount)
+	{
+		int i = _nextTask++;
+		const std::function<void(int)> &task = *_task;
+		lock.unlock();
+		std::exception_ptr error;
+		try
+		{
+			task(i);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		lock.lock();
+		if (error && !_error)
+		{
+			_error = error;
+		}
+		if (++_finishedTasks == _taskCount)
+		{
+			_done.notify_all();
+		}
+	}
+}
+
+/**
+ * Runs the function for all numbers from 0 to count, in any order and on any thread.
+ * Calling thread takes part in work too. First error thrown by any task is rethrown here.
+ * If pool is already busy, all tasks are run by calling thread.
+ * @param count Number of tasks.
+ * @param task Function called with number of task.
+ */
+void ThreadPool::run(int count, const std::function<void(int)> &task)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (_threads.empty() || count == 1)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_task)
+	{
+		// pool is already busy, called from a task or other thread
+		lock.unlock();
+		for (int i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+	_task = &task;
+	_taskCount = count;
+	_nextTask = 0;
+	_finishedTasks = 0;
+	_error = nullptr;
+	++_generation;
+	_wake.notify_all();
+
+	runTasks(lock);
+	_done.wait(lock, [&]{ return _finishedTasks == _taskCount; });
+	_task = nullptr;
+
+	std::exception_ptr error = _error;
+	_error = nullptr;
+	lock.unlock();
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+}
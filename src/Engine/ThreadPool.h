@@ -0,0 +1,64 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+
+namespace OpenXcom
+{
+
+/**
+ * Small pool of worker threads used to split independent work into parts.
+ * Work is always given as a number of tasks and the calling thread
+ * helps with them, so call returns only when all tasks are done.
+ * Tasks must not touch any shared state that is not read-only.
+ */
+class ThreadPool
+{
+	std::vector<std::thread> _threads;
+	std::mutex _mutex;
+	std::condition_variable _wake, _done;
+	const std::function<void(int)> *_task;
+	int _taskCount, _nextTask, _finishedTasks;
+	unsigned _generation;
+	bool _quit;
+	std::exception_ptr _error;
+
+	/// Main loop of worker thread.
+	void work();
+	/// Runs tasks until there are none left.
+	void runTasks(std::unique_lock<std::mutex> &lock);
+public:
+	/// Creates pool with given number of additional threads.
+	ThreadPool(int threads);
+	/// Stops all threads.
+	~ThreadPool();
+	/// Gets the shared pool sized by options.
+	static ThreadPool &getShared();
+	/// Gets number of threads working on tasks, including calling one.
+	int getThreadCount() const { return (int)_threads.size() + 1; }
+	/// Runs the function for every number from 0 to count and waits for the result.
+	void run(int count, const std::function<void(int)> &task);
+};
+
+}
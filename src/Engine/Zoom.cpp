@@ -17,6 +17,10 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include "Zoom.h"
 
 #include "Surface.h"
@@ -25,6 +29,7 @@
 #include "Screen.h"
 
 #include "OpenGL.h"
+#include "ThreadPool.h"
 
 // Scale2X
 #include "Scalers/scalebit.h"
@@ -653,6 +658,127 @@ bool Zoom::haveSSE2()
 
 #endif
 
+/**
+ * Splits rows of image into horizontal bands and processes them on the shared thread pool.
+ * Scalers read rows around the band as neighbours but write only rows of their own band.
+ * @param firstRow First row to process.
+ * @param lastRow Row after last one to process.
+ * @param minRows Smallest band worth giving to other thread.
+ * @param band Function processing rows [first, last).
+ */
+static void runInBands(int firstRow, int lastRow, int minRows, const std::function<void(int, int)> &band)
+{
+	ThreadPool &pool = ThreadPool::getShared();
+	int rows = lastRow - firstRow;
+	int bands = std::max(1, std::min(pool.getThreadCount() * 2, rows / minRows));
+	pool.run(bands, [&](int i)
+	{
+		band(firstRow + rows * i / bands, firstRow + rows * (i + 1) / bands);
+	});
+}
+
+/**
+ * Gets first destination row that is zoomed from given source row or rows after it.
+ * @param row Source row.
+ * @param srcHeight Height of source.
+ * @param dstHeight Height of destination.
+ * @return Destination row.
+ */
+static int getZoomedRow(int row, int srcHeight, int dstHeight)
+{
+	return (int)(((long long)row * dstHeight + srcHeight - 1) / srcHeight);
+}
+
+/**
+ * Logs average time spent by the scaler, once every few hundred frames.
+ * @param name Name of used scaler.
+ * @param start Time when scaling started.
+ */
+static void logScalerTime(const char *name, std::chrono::steady_clock::time_point start)
+{
+	static const char *lastName = nullptr;
+	static std::chrono::steady_clock::duration total;
+	static int frames = 0;
+	const int framesPerLog = 600;
+
+	if (name != lastName)
+	{
+		lastName = name;
+		total = std::chrono::steady_clock::duration::zero();
+		frames = 0;
+	}
+	total += std::chrono::steady_clock::now() - start;
+	if (++frames == framesPerLog)
+	{
+		double ms = std::chrono::duration<double, std::milli>(total).count() / frames;
+		Log(LOG_DEBUG) << "Scaler " << name << ": " << ms << " ms per frame using " << ThreadPool::getShared().getThreadCount() << " threads";
+		total = std::chrono::steady_clock::duration::zero();
+		frames = 0;
+	}
+}
+
+/**
+ * Zooms one 8-bit row by a factor of 2, every source pixel is written twice.
+ * @param sp Source row.
+ * @param dp Destination row.
+ * @param width Width of source row.
+ */
+static void zoomRow2X(const Uint8 *sp, Uint8 *dp, int width)
+{
+	int x = 0;
+#ifdef __SSE2__
+	static bool _haveSSE2 = Zoom::haveSSE2();
+	if (_haveSSE2)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(sp + x));
+			_mm_storeu_si128((__m128i*)(dp + 2 * x), _mm_unpacklo_epi8(v, v));
+			_mm_storeu_si128((__m128i*)(dp + 2 * x + 16), _mm_unpackhi_epi8(v, v));
+		}
+	}
+#endif
+	for (; x < width; ++x)
+	{
+		dp[2 * x] = sp[x];
+		dp[2 * x + 1] = sp[x];
+	}
+}
+
+/**
+ * Zooms one 8-bit row by a factor of 4, every source pixel is written four times.
+ * @param sp Source row.
+ * @param dp Destination row.
+ * @param width Width of source row.
+ */
+static void zoomRow4X(const Uint8 *sp, Uint8 *dp, int width)
+{
+	int x = 0;
+#ifdef __SSE2__
+	static bool _haveSSE2 = Zoom::haveSSE2();
+	if (_haveSSE2)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(sp + x));
+			__m128i lo = _mm_unpacklo_epi8(v, v);
+			__m128i hi = _mm_unpackhi_epi8(v, v);
+			_mm_storeu_si128((__m128i*)(dp + 4 * x), _mm_unpacklo_epi16(lo, lo));
+			_mm_storeu_si128((__m128i*)(dp + 4 * x + 16), _mm_unpackhi_epi16(lo, lo));
+			_mm_storeu_si128((__m128i*)(dp + 4 * x + 32), _mm_unpacklo_epi16(hi, hi));
+			_mm_storeu_si128((__m128i*)(dp + 4 * x + 48), _mm_unpackhi_epi16(hi, hi));
+		}
+	}
+#endif
+	for (; x < width; ++x)
+	{
+		dp[4 * x] = sp[x];
+		dp[4 * x + 1] = sp[x];
+		dp[4 * x + 2] = sp[x];
+		dp[4 * x + 3] = sp[x];
+	}
+}
+
 /**
  * Wrapper around various software and OpenGL screen buffer pushing functions which zoom.
  * Basically called just from Screen::flip()
@@ -664,11 +790,17 @@ bool Zoom::haveSSE2()
  * @param leftBlackBand Size of left black band in pixels (letterboxing).
  * @param rightBlackBand Size of right black band in pixels (letterboxing).
  * @param glOut OpenGL output.
+ * @param firstRow First row of src that changed since last flip.
+ * @param lastRow Row after last one of src that changed since last flip.
+ * @return Part of dst that was changed.
  */
-void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut)
+SDL_Rect Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut, int firstRow, int lastRow)
 {
 	int dstWidth = dst->w - leftBlackBand - rightBlackBand;
 	int dstHeight = dst->h - topBlackBand - bottomBlackBand;
+	SDL_Rect changed = {0, 0, (Uint16)dst->w, (Uint16)dst->h};
+	firstRow = std::max(firstRow, 0);
+	lastRow = std::max(std::min(lastRow, src->h), firstRow);
 	if (Screen::useOpenGL())
 	{
 #ifndef __NO_OPENGL
@@ -683,12 +815,19 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
 	}
 	else if (topBlackBand <= 0 && bottomBlackBand <= 0 && leftBlackBand <= 0 && rightBlackBand <= 0)
 	{
-		_zoomSurfaceY(src, dst, 0, 0);
+		_zoomSurfaceY(src, dst, 0, 0, firstRow, lastRow);
+		changed.y = getZoomedRow(firstRow, src->h, dst->h);
+		changed.h = getZoomedRow(lastRow, src->h, dst->h) - changed.y;
 	}
 	else if (dstWidth == src->w && dstHeight == src->h)
 	{
-		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)topBlackBand, (Uint16)src->w, (Uint16)src->h};
-		SDL_BlitSurface(src, NULL, dst, &dstrect);
+		SDL_Rect srcrect = {0, (Sint16)firstRow, (Uint16)src->w, (Uint16)(lastRow - firstRow)};
+		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)(topBlackBand + firstRow), (Uint16)src->w, (Uint16)(lastRow - firstRow)};
+		SDL_BlitSurface(src, &srcrect, dst, &dstrect);
+		changed.x = leftBlackBand;
+		changed.y = topBlackBand + firstRow;
+		changed.w = src->w;
+		changed.h = lastRow - firstRow;
 	}
 	else
 	{
@@ -702,6 +841,7 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
 		SDL_BlitSurface(tmp, NULL, dst, &dstrect);
 		SDL_FreeSurface(tmp);
 	}
+	return changed;
 }
 
 
@@ -719,15 +859,28 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
  * @param flipy Flag indicating if the image should be vertically flipped.
  * @return 0 for success or -1 for error.
  */
-int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy)
+int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, int firstRow, int lastRow)
 {
 	int x, y;
 	static Uint32 *sax, *say;
 	Uint32 *csax, *csay;
 	int csx, csy;
-	Uint8 *sp, *dp, *csp;
+	Uint8 *csp;
 	int dgap;
 	static bool proclaimed = false;
+	auto start = std::chrono::steady_clock::now();
+
+	firstRow = std::max(firstRow, 0);
+	lastRow = std::min(lastRow, src->h);
+	if (flipy)
+	{
+		firstRow = 0;
+		lastRow = src->h;
+	}
+	if (firstRow >= lastRow)
+	{
+		return 0;
+	}
 
 	if (Screen::use32bitScaler())
 	{
@@ -738,7 +891,11 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 			{
 				if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor)
 				{
-					xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB);
+					runInBands(firstRow, lastRow, 8, [&](int first, int last)
+					{
+						xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB, xbrz::ScalerCfg(), first, last);
+					});
+					logScalerTime("xBRZ", start);
 					return 0;
 				}
 			}
@@ -758,19 +915,31 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 
 			if (dst->w == src->w * 2 && dst->h == src->h * 2)
 			{
-				hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				runInBands(firstRow, lastRow, 8, [&](int first, int last)
+				{
+					hq2x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
+				logScalerTime("hq2x", start);
 				return 0;
 			}
 
 			if (dst->w == src->w * 3 && dst->h == src->h * 3)
 			{
-				hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				runInBands(firstRow, lastRow, 8, [&](int first, int last)
+				{
+					hq3x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
+				logScalerTime("hq3x", start);
 				return 0;
 			}
 
 			if (dst->w == src->w * 4 && dst->h == src->h * 4)
 			{
-				hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				runInBands(firstRow, lastRow, 8, [&](int first, int last)
+				{
+					hq4x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, first, last);
+				});
+				logScalerTime("hq4x", start);
 				return 0;
 			}
 		}
@@ -784,6 +953,7 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 			if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor && !scale_precondition(factor, src->format->BytesPerPixel, src->w, src->h))
 			{
 				scale(factor, dst->pixels, dst->pitch, src->pixels, src->pitch, src->format->BytesPerPixel, src->w, src->h);
+				logScalerTime("scale2x", start);
 				return 0;
 			}
 		}
@@ -859,8 +1029,7 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	/*
 	* Pointer setup
 	*/
-	sp = csp = (Uint8 *) src->pixels;
-	dp = (Uint8 *) dst->pixels;
+	csp = (Uint8 *) src->pixels;
 	dgap = dst->pitch - dst->w;
 
 	if (flipx) csp += (src->w-1);
@@ -883,49 +1052,73 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	}
 	csy = 0;
 	csay = say;
+	*csay = 0;
 	for (y = 0; y < dst->h; y++) {
 		csy += src->h;
-		*csay = 0;
+		int rows = 0;
 		while (csy >= dst->h) {
 			csy -= dst->h;
-			(*csay)++;
+			rows++;
 		}
-		(*csay) *= src->pitch * (flipy ? -1 : 1);
+		/*
+		* Unlike columns, rows store offset from the first row
+		* so every band can find its starting row
+		*/
+		*(csay + 1) = *csay + rows * src->pitch * (flipy ? -1 : 1);
 		csay++;
 	}
 	/*
 	* Draw
 	*/
-	csay = say;
-	for (y = 0; y < dst->h; y++) {
-		csax = sax;
-		sp = csp;
-		for (x = 0; x < dst->w; x++) {
-			/*
-			* Draw
-			*/
-			*dp = *sp;
+	int dstFirstRow = getZoomedRow(firstRow, src->h, dst->h);
+	int dstLastRow = getZoomedRow(lastRow, src->h, dst->h);
+	runInBands(dstFirstRow, dstLastRow, 16, [&](int first, int last)
+	{
+		Uint8 *dp = (Uint8 *) dst->pixels + first * dst->pitch;
+		for (int y = first; y < last; y++) {
+			Uint8 *sp = csp + (Sint32)say[y];
 			/*
-			* Advance source pointers
+			* Rows taken from the same source row are equal,
+			* copy the previous one instead of zooming it again
 			*/
-			sp += (*csax);
-			csax++;
+			if (y > first && say[y] == say[y - 1]) {
+				memcpy(dp, dp - dst->pitch, dst->w);
+				dp += dst->pitch;
+				continue;
+			}
+			if (!flipx && dst->w == src->w * 2) {
+				zoomRow2X(sp, dp, src->w);
+				dp += dst->pitch;
+				continue;
+			}
+			if (!flipx && dst->w == src->w * 4) {
+				zoomRow4X(sp, dp, src->w);
+				dp += dst->pitch;
+				continue;
+			}
+			Uint32 *csax = sax;
+			for (int x = 0; x < dst->w; x++) {
+				/*
+				* Draw
+				*/
+				*dp = *sp;
+				/*
+				* Advance source pointers
+				*/
+				sp += (*csax);
+				csax++;
+				/*
+				* Advance destination pointer
+				*/
+				dp++;
+			}
 			/*
-			* Advance destination pointer
+			* Advance destination pointers
 			*/
-			dp++;
+			dp += dgap;
 		}
-		/*
-		* Advance source pointer (for row)
-		*/
-		csp += (*csay);
-		csay++;
-
-		/*
-		* Advance destination pointers
-		*/
-		dp += dgap;
-	}
+	});
+	logScalerTime("nearest", start);
 
 	/*
 	* Never remove temp arrays
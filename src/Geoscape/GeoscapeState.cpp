@@ -1144,21 +1144,13 @@ void GeoscapeState::time5Seconds()
 			{
 				int score = (*j)->getRules()->getScore();
 				_game->getMasterMind()->updateLoyalty(-score);
-				for (std::vector<Country*>::iterator country = _game->getSavedGame()->getCountries()->begin(); country != _game->getSavedGame()->getCountries()->end(); ++country)
+				if (Country *country = _game->getSavedGame()->locateCountry(**j))
 				{
-					if ((*country)->getRules()->insideCountry((*j)->getLongitude(), (*j)->getLatitude()))
-					{
-						(*country)->addActivityXcom(-score);
-						break;
-					}
+					country->addActivityXcom(-score);
 				}
-				for (std::vector<Region*>::iterator region = _game->getSavedGame()->getRegions()->begin(); region != _game->getSavedGame()->getRegions()->end(); ++region)
+				if (Region *region = _game->getSavedGame()->getRegionAt((*j)->getLongitude(), (*j)->getLatitude()))
 				{
-					if ((*region)->getRules()->insideRegion((*j)->getLongitude(), (*j)->getLatitude()))
-					{
-						(*region)->addActivityXcom(-score);
-						break;
-					}
+					region->addActivityXcom(-score);
 				}
 				// if a transport craft has been shot down, kill all the soldiers on board.
 				if ((*j)->getRules()->getMaxUnits() > 0)
@@ -1990,23 +1982,15 @@ void GeoscapeState::time30Minutes()
 			FALLTHROUGH;
 		case Ufo::FLYING:
 			// Get area
-			for (auto region : *_game->getSavedGame()->getRegions())
+			if (Region *region = _game->getSavedGame()->getRegionAt(ufo->getLongitude(), ufo->getLatitude()))
 			{
-				if (region->getRules()->insideRegion(ufo->getLongitude(), ufo->getLatitude()))
-				{
-					// #FINNIKTODO loyalty change here?
-					region->addActivityAlien(points);
-					break;
-				}
+				// #FINNIKTODO loyalty change here?
+				region->addActivityAlien(points);
 			}
 			// Get country
-			for (auto country : *_game->getSavedGame()->getCountries())
+			if (Country *country = _game->getSavedGame()->locateCountry(*ufo))
 			{
-				if (country->getRules()->insideCountry(ufo->getLongitude(), ufo->getLatitude()))
-				{
-					country->addActivityAlien(points);
-					break;
-				}
+				country->addActivityAlien(points);
 			}
 
 			// Detection ufo state
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Globe.h"
+#include <algorithm>
 #include "../fmath.h"
 #include "../Engine/Action.h"
 #include "../Engine/SurfaceSet.h"
@@ -345,8 +346,11 @@ Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y
 	_cenLat = _game->getSavedGame()->getGlobeLatitude();
 	_zoom = _game->getSavedGame()->getGlobeZoom();
 	_zoomOld = _zoom;
+	_cacheLon = _cacheLat = 0.0;
+	_cacheRadius = -1.0;
+	_cacheX = _cacheY = 0;
 
-	setupRadii(width, height);
+	setupRadii(height);
 	setZoom(_zoom);
 
 	cachePolygons();
@@ -449,7 +453,8 @@ Polygon* Globe::getPolygonFromLonLat(double lon, double lat) const
 	double coslat = cos(lat);
 	double sinlat = sin(lat);
 
-	for (std::list<Polygon*>::iterator i = _rules->getPolygons()->begin(); i != _rules->getPolygons()->end(); ++i)
+	const std::vector<Polygon*> &polygons = _rules->getPolygonsNear(lon, lat);
+	for (std::vector<Polygon*>::const_iterator i = polygons.begin(); i != polygons.end(); ++i)
 	{
 		double x, y, z, x2, y2;
 		double clat, clon;
@@ -836,7 +841,17 @@ std::vector<Target*> Globe::getTargets(int x, int y, bool craft, Craft *currentC
  */
 void Globe::cachePolygons()
 {
+	if (_cacheLon == _cenLon && _cacheLat == _cenLat && _cacheRadius == _radius && _cacheX == _cenX && _cacheY == _cenY)
+	{
+		// redrawn without moving, e.g. blinking markers
+		return;
+	}
 	cache(_rules->getPolygons(), &_cacheLand);
+	_cacheLon = _cenLon;
+	_cacheLat = _cenLat;
+	_cacheRadius = _radius;
+	_cacheX = _cenX;
+	_cacheY = _cenY;
 }
 
 /**
@@ -853,16 +868,38 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 	}
 	cache->clear();
 
+	// Latitudes never change, so their sine and cosine are only calculated once
+	if (_polygonSinLat.empty())
+	{
+		for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+		{
+			for (int j = 0; j < (*i)->getPoints(); ++j)
+			{
+				_polygonSinLat.push_back(sin((*i)->getLatitude(j)));
+				_polygonCosLat.push_back(cos((*i)->getLatitude(j)));
+			}
+		}
+	}
+	const double sinCenLat = sin(_cenLat);
+	const double cosCenLat = cos(_cenLat);
+	std::vector<double> cosLon;
+
 	// Pre-calculate values to cache
-	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+	size_t first = 0;
+	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); first += (*i)->getPoints(), ++i)
 	{
+		const double *sinLat = &_polygonSinLat[first];
+		const double *cosLat = &_polygonCosLat[first];
+
 		// Is quad on the back face?
 		double closest = 0.0;
 		double z;
 		double furthest = 0.0;
+		cosLon.resize((*i)->getPoints());
 		for (int j = 0; j < (*i)->getPoints(); ++j)
 		{
-			z = cos(_cenLat) * cos((*i)->getLatitude(j)) * cos((*i)->getLongitude(j) - _cenLon) + sin(_cenLat) * sin((*i)->getLatitude(j));
+			cosLon[j] = cos((*i)->getLongitude(j) - _cenLon);
+			z = cosCenLat * cosLat[j] * cosLon[j] + sinCenLat * sinLat[j];
 			if (z > closest)
 				closest = z;
 			else if (z < furthest)
@@ -873,11 +910,11 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 
 		Polygon* p = new Polygon(**i);
 
-		// Convert coordinates
+		// Convert coordinates, same as polarToCart
 		for (int j = 0; j < p->getPoints(); ++j)
 		{
-			Sint16 x, y;
-			polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
+			Sint16 x = _cenX + (Sint16)floor(_radius * cosLat[j] * sin(p->getLongitude(j) - _cenLon));
+			Sint16 y = _cenY + (Sint16)floor(_radius * (cosCenLat * sinLat[j] - sinCenLat * cosLat[j] * cosLon[j]));
 			p->setX(j, x);
 			p->setY(j, y);
 		}
@@ -1050,7 +1087,7 @@ Cord Globe::getSunDirection(double lon, double lat) const
 
 void Globe::drawShadow()
 {
-	auto earth = ShaderMove<Cord>(SurfaceRaw<Cord>(_earthData[_zoom], getWidth(), getHeight()));
+	auto earth = ShaderMove<Cord>(SurfaceRaw<Cord>(getEarthData(_zoom), getWidth(), getHeight()));
 	auto noise = ShaderRepeat<Sint16>(SurfaceRaw<Sint16>(static_data.random_noise, static_data.random_surf_size, static_data.random_surf_size));
 
 	earth.setMove(_cenX-getWidth()/2, _cenY-getHeight()/2);
@@ -2061,16 +2098,15 @@ void Globe::resize()
 	_clipper->Wybot = height;
 	_cenX = width / 2;
 	_cenY = height / 2;
-	setupRadii(width, height);
+	setupRadii(height);
 	invalidate();
 }
 
 /*
  * Set up the Radius of earth at the various zoom levels.
- * @param width the new width of the globe.
  * @param height the new height of the globe.
  */
-void Globe::setupRadii(int width, int height)
+void Globe::setupRadii(int height)
 {
 	_zoomRadius.clear();
 
@@ -2084,18 +2120,46 @@ void Globe::setupRadii(int width, int height)
 	_radius = _zoomRadius[_zoom];
 	_radiusStep = (_zoomRadius[DOGFIGHT_ZOOM] - _zoomRadius[0]) / 10.0;
 
+	//normal fields are filled on first use of each radius
+	_earthData.clear();
 	_earthData.resize(_zoomRadius.size());
-	//filling normal field for each radius
+	_earthDataUsed.clear();
+}
 
-	for (size_t r = 0; r<_zoomRadius.size(); ++r)
+/**
+ * Gets the normal field of the earth for a zoom level.
+ * Only the last few used levels are kept, as each one holds
+ * a vector for every pixel of the globe.
+ * @param zoom Zoom level.
+ * @return Normal of each pixel.
+ */
+std::vector<Cord> &Globe::getEarthData(size_t zoom)
+{
+	auto used = std::find(_earthDataUsed.begin(), _earthDataUsed.end(), zoom);
+	if (used != _earthDataUsed.end())
 	{
-		_earthData[r].resize(width * height);
-		for (int j=0; j<height; ++j)
-			for (int i=0; i<width; ++i)
-			{
-				_earthData[r][width*j + i] = static_data.circle_norm(width/2, height/2, _zoomRadius[r], i+.5, j+.5);
-			}
+		_earthDataUsed.erase(used);
+		_earthDataUsed.push_back(zoom);
+		return _earthData[zoom];
 	}
+
+	if (_earthDataUsed.size() >= MAX_EARTH_DATA_LEVELS)
+	{
+		std::vector<Cord>().swap(_earthData[_earthDataUsed.front()]);
+		_earthDataUsed.erase(_earthDataUsed.begin());
+	}
+	_earthDataUsed.push_back(zoom);
+
+	const int width = getWidth();
+	const int height = getHeight();
+	std::vector<Cord> &data = _earthData[zoom];
+	data.resize(width * height);
+	for (int j=0; j<height; ++j)
+		for (int i=0; i<width; ++i)
+		{
+			data[width*j + i] = static_data.circle_norm(width/2, height/2, _zoomRadius[zoom], i+.5, j+.5);
+		}
+	return data;
 }
 
 /**
@@ -49,6 +49,7 @@ private:
 	static const int NEAR_RADIUS = 25;
 	static const int MAX_DRAW_RADAR_CIRCLE_RADIUS = 10000;
 	static const size_t DOGFIGHT_ZOOM = 3;
+	static const size_t MAX_EARTH_DATA_LEVELS = 2;
 	static const int CITY_MARKER = 8;
 	static const double ROTATE_LONGITUDE;
 	static const double ROTATE_LATITUDE;
@@ -65,10 +66,17 @@ private:
 	int _blink;
 	Timer *_blinkTimer, *_rotTimer;
 	std::list<Polygon*> _cacheLand;
+	///view the land cache was projected for
+	double _cacheLon, _cacheLat, _cacheRadius;
+	Sint16 _cacheX, _cacheY;
+	///sine and cosine of latitude of every polygon point, in polygon order
+	std::vector<double> _polygonSinLat, _polygonCosLat;
 	FastLineClip *_clipper;
 	double _radius, _radiusStep;
-	///normal of each pixel in earth globe per zoom level
+	///normal of each pixel in earth globe per zoom level, only filled for recently used levels
 	std::vector<std::vector<Cord> > _earthData;
+	///zoom levels with filled normals, most recently used last
+	std::vector<size_t> _earthDataUsed;
 	///list of dimension of earth on screen per zoom level
 	std::vector<double> _zoomRadius;
 
@@ -102,7 +110,9 @@ private:
 	/// Draw target marker.
 	void drawTarget(Target *target, Surface *surface);
 	/// Set up the radius of earth and stuff.
-	void setupRadii(int width, int height);
+	void setupRadii(int height);
+	/// Gets the normal of each pixel for a zoom level, filling it if needed.
+	std::vector<Cord> &getEarthData(size_t zoom);
 public:
 	static Uint8 OCEAN_COLOR;
 	static bool OCEAN_SHADING;
@@ -42,6 +42,7 @@
 #include "../Engine/Logger.h"
 #include "../Engine/ScriptBind.h"
 #include "../Engine/Collections.h"
+#include "../Engine/ThreadPool.h"
 #include "SoundDefinition.h"
 #include "ExtraSprites.h"
 #include "CustomPalettes.h"
@@ -343,6 +344,14 @@ public:
 	{
 		updateConst("RuleList." + ModNameCurrent, (int)i);
 		_modCurr = i;
+		for (const auto& p : _modNames)
+		{
+			if (i == p.second)
+			{
+				_currentModName = p.first;
+				break;
+			}
+		}
 	}
 
 	/// Get script values
@@ -2028,6 +2037,10 @@ void Mod::loadAll()
 	{
 		Log(LOG_WARNING) << "Validation of mod data reduced, game can behave incorrectly";
 	}
+	if (Options::debug && Options::oxceScriptOptimizations && !ScriptGlobal::verifyOptimizations())
+	{
+		Log(LOG_ERROR) << "Script optimizations give different results, disable them with 'oxceScriptOptimizations: false'";
+	}
 	_scriptGlobal->beginLoad();
 	_modData.clear();
 	_modData.resize(mods.size());
@@ -2085,7 +2098,41 @@ void Mod::loadAll()
 	_soundOffsetBattle = _sounds["BATTLE.CAT"]->getMaxSharedSounds();
 	_soundOffsetGeo = _sounds["GEO.CAT"]->getMaxSharedSounds();
 
+	Log(LOG_INFO) << "Parsing rulesets...";
+	// reading and parsing files do not depend on each other, only loading them must keep order
+	Uint32 parseStart = SDL_GetTicks();
+	std::vector<std::vector<ModRulesetFile>> parsedFiles(mods.size());
+	std::vector<std::pair<size_t, size_t>> parseTasks;
+	for (size_t i = 0; mods.size() > i; ++i)
+	{
+		parsedFiles[i].resize(mods[i].second.size());
+		for (size_t j = 0; mods[i].second.size() > j; ++j)
+		{
+			parseTasks.push_back(std::make_pair(i, j));
+		}
+	}
+	auto parseFile = [&](int task)
+	{
+		const auto &pos = parseTasks[task];
+		ModRulesetFile &file = parsedFiles[pos.first][pos.second];
+		try
+		{
+			file.doc = mods[pos.first].second[pos.second].getYAMLQuiet();
+			file.parsed = true;
+		}
+		catch (...)
+		{
+			// file is parsed again when loaded, so errors are logged in order with errors from files before it
+		}
+	};
+	if (Options::oxceParallelRulesetParsing)
+	{
+		ThreadPool::getShared().run((int)parseTasks.size(), parseFile);
+	}
+	Log(LOG_INFO) << "Parsing rulesets done, " << parseTasks.size() << " files in " << (SDL_GetTicks() - parseStart) << " ms.";
+
 	Log(LOG_INFO) << "Loading rulesets...";
+	Uint32 loadStart = SDL_GetTicks();
 	// load rest rulesets
 	for (size_t i = 0; mods.size() > i; ++i)
 	{
@@ -2093,15 +2140,16 @@ void Mod::loadAll()
 		{
 			_modCurrent = &_modData.at(i);
 			_scriptGlobal->setMod((int)_modCurrent->offset);
-			loadMod(mods[i].second, parser);
+			loadMod(mods[i].second, parsedFiles[i], parser);
 		}
 		catch (Exception &e)
 		{
 			const std::string &modId = mods[i].first;
 			throwModOnErrorHelper(modId, e.what());
 		}
+		parsedFiles[i].clear();
 	}
-	Log(LOG_INFO) << "Loading rulesets done.";
+	Log(LOG_INFO) << "Loading rulesets done in " << (SDL_GetTicks() - loadStart) << " ms.";
 
 	//back master
 	_modCurrent = &_modData.at(0);
@@ -2307,24 +2355,25 @@ void Mod::loadAll()
  * Loads a list of rulesets from YAML files for the mod at the specified index. The first
  * mod loaded should be the master at index 0, then 1, and so on.
  * @param rulesetFiles List of rulesets to load.
+ * @param parsedFiles Content of ruleset files parsed in advance, files not parsed yet are parsed here.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers)
+void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, const std::vector<ModRulesetFile> &parsedFiles, ModScript &parsers)
 {
-	for (auto i = rulesetFiles.begin(); i != rulesetFiles.end(); ++i)
+	for (size_t i = 0; rulesetFiles.size() > i; ++i)
 	{
-		Log(LOG_VERBOSE) << "- " << i->fullpath;
+		Log(LOG_VERBOSE) << "- " << rulesetFiles[i].fullpath;
 		try
 		{
-			loadFile(*i, parsers);
+			loadFile(parsedFiles[i].parsed ? parsedFiles[i].doc : rulesetFiles[i].getYAML(), parsers);
 		}
 		catch (Exception &e)
 		{
-			throw Exception(i->fullpath + ": " + std::string(e.what()));
+			throw Exception(rulesetFiles[i].fullpath + ": " + std::string(e.what()));
 		}
 		catch (YAML::Exception &e)
 		{
-			throw Exception(i->fullpath + ": " + std::string(e.what()));
+			throw Exception(rulesetFiles[i].fullpath + ": " + std::string(e.what()));
 		}
 	}
 
@@ -2499,14 +2548,13 @@ void Mod::loadConstants(const YAML::Node &node)
 }
 
 /**
- * Loads a ruleset's contents from a YAML file.
+ * Loads a ruleset's contents from a parsed YAML file.
  * Rules that match pre-existing rules overwrite them.
- * @param filename YAML filename.
+ * @param doc YAML file content.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadFile(const FileMap::FileRecord &filerec, ModScript &parsers)
+void Mod::loadFile(YAML::Node doc, ModScript &parsers)
 {
-	auto doc = filerec.getYAML();
 
 	if (const YAML::Node &extended = doc["extended"])
 	{
@@ -126,6 +126,17 @@ struct ModData
 	size_t size;
 };
 
+/**
+ * Ruleset file parsed before it is loaded
+ */
+struct ModRulesetFile
+{
+	/// Content of file
+	YAML::Node doc;
+	/// Was file parsed successfully, otherwise it is parsed again when loaded
+	bool parsed = false;
+};
+
 /**
  * Helper exception representing the final message with all the required context for the end user to fix the errors in rulesets
  */
@@ -344,8 +355,8 @@ private:
 	/// Loads a ruleset from a YAML file that have basic resources configuration.
 	void loadResourceConfigFile(const FileMap::FileRecord &filerec);
 	void loadConstants(const YAML::Node &node);
-	/// Loads a ruleset from a YAML file.
-	void loadFile(const FileMap::FileRecord &filerec, ModScript &parsers);
+	/// Loads a ruleset from a parsed YAML file.
+	void loadFile(YAML::Node doc, ModScript &parsers);
 	/// Loads a ruleset element.
 	template <typename T>
 	T *loadRule(const YAML::Node &node, std::map<std::string, T*> *map, std::vector<std::string> *index = 0, const std::string &key = "type") const;
@@ -363,7 +374,7 @@ private:
 	/// Creates a transparency lookup table for a given palette.
 	void createTransparencyLUT(Palette *pal);
 	/// Loads a specified mod content.
-	void loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers);
+	void loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, const std::vector<ModRulesetFile> &parsedFiles, ModScript &parsers);
 	/// Loads resources from vanilla.
 	void loadVanillaResources();
 	/// Loads resources from extra rulesets.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "RuleGlobe.h"
+#include <cmath>
 #include <SDL_endian.h>
 #include "../Engine/Exception.h"
 #include "Polygon.h"
@@ -62,6 +63,7 @@ RuleGlobe::~RuleGlobe()
  */
 void RuleGlobe::load(const YAML::Node &node)
 {
+	_polygonCells.clear();
 	if (node["data"])
 	{
 		for (std::list<Polygon*>::iterator i = _polygons.begin(); i != _polygons.end(); ++i)
@@ -148,6 +150,102 @@ std::list<Polygon*> *RuleGlobe::getPolygons()
 	return &_polygons;
 }
 
+/**
+ * Builds grid of polygons used by point queries.
+ * Polygon can contain point only if whole polygon is in front of it,
+ * so every point that it contains lays inside of circle around polygon points.
+ * Cell gets every polygon whose circle is close enough to cell center.
+ */
+void RuleGlobe::buildPolygonCells()
+{
+	const int cellsLat = 180 / POLYGON_CELL_SIZE;
+	const int cellsLon = 360 / POLYGON_CELL_SIZE;
+	const double cellSize = POLYGON_CELL_SIZE * M_PI / 180;
+	// every point of cell is at most this far from its center
+	const double cellRadius = cellSize + 1e-6;
+
+	struct Cap
+	{
+		Polygon *polygon;
+		double x, y, z, radius;
+	};
+	std::vector<Cap> caps;
+	for (auto* polygon : _polygons)
+	{
+		Cap cap = { polygon, 0.0, 0.0, 0.0, M_PI };
+		for (int j = 0; j < polygon->getPoints(); ++j)
+		{
+			cap.x += cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j));
+			cap.y += cos(polygon->getLatitude(j)) * sin(polygon->getLongitude(j));
+			cap.z += sin(polygon->getLatitude(j));
+		}
+		double length = sqrt(cap.x * cap.x + cap.y * cap.y + cap.z * cap.z);
+		if (length > 1e-6)
+		{
+			cap.x /= length;
+			cap.y /= length;
+			cap.z /= length;
+			cap.radius = 0;
+			for (int j = 0; j < polygon->getPoints(); ++j)
+			{
+				double dot = cap.x * cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j)) + cap.y * cos(polygon->getLatitude(j)) * sin(polygon->getLongitude(j)) + cap.z * sin(polygon->getLatitude(j));
+				cap.radius = std::max(cap.radius, acos(Clamp(dot, -1.0, 1.0)));
+			}
+		}
+		if (cap.radius > M_PI / 2)
+		{
+			// too big to be sure of anything, check it everywhere
+			cap.radius = M_PI;
+		}
+		caps.push_back(cap);
+	}
+
+	_polygonCells.assign(cellsLat * cellsLon, std::vector<Polygon*>());
+	for (int i = 0; i < cellsLat; ++i)
+	{
+		double lat = -M_PI / 2 + (i + 0.5) * cellSize;
+		for (int j = 0; j < cellsLon; ++j)
+		{
+			double lon = (j + 0.5) * cellSize;
+			double x = cos(lat) * cos(lon), y = cos(lat) * sin(lon), z = sin(lat);
+			auto &cell = _polygonCells[i * cellsLon + j];
+			for (const auto &cap : caps)
+			{
+				double dot = x * cap.x + y * cap.y + z * cap.z;
+				if (cap.radius >= M_PI || acos(Clamp(dot, -1.0, 1.0)) <= cap.radius + cellRadius)
+				{
+					cell.push_back(cap.polygon);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Gets polygons that can contain given point, in the same order as in list of all polygons.
+ * @param lon Longitude of point.
+ * @param lat Latitude of point.
+ * @return Polygons near point.
+ */
+const std::vector<Polygon*> &RuleGlobe::getPolygonsNear(double lon, double lat)
+{
+	const int cellsLat = 180 / POLYGON_CELL_SIZE;
+	const int cellsLon = 360 / POLYGON_CELL_SIZE;
+	const double cellSize = POLYGON_CELL_SIZE * M_PI / 180;
+	if (_polygonCells.empty())
+	{
+		buildPolygonCells();
+	}
+	lon = fmod(lon, 2 * M_PI);
+	if (lon < 0)
+	{
+		lon += 2 * M_PI;
+	}
+	int i = Clamp((int)floor((lat + M_PI / 2) / cellSize), 0, cellsLat - 1);
+	int j = Clamp((int)floor(lon / cellSize), 0, cellsLon - 1);
+	return _polygonCells[i * cellsLon + j];
+}
+
 /**
  * Returns the list of polylines in the globe.
  * @return Pointer to the list of polylines.
@@ -19,6 +19,7 @@
  */
 #include <list>
 #include <string>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -39,7 +40,15 @@ private:
 	std::list<Polygon*> _polygons;
 	std::list<Polyline*> _polylines;
 	std::map<int, Texture*> _textures;
+	/// Grid of latitude/longitude cells with polygons that can contain points in them.
+	std::vector<std::vector<Polygon*> > _polygonCells;
+
+	/// Builds grid of polygons for point queries.
+	void buildPolygonCells();
 public:
+	/// Size of one cell of polygon grid in degrees.
+	static constexpr int POLYGON_CELL_SIZE = 5;
+
 	/// Creates a blank globe ruleset.
 	RuleGlobe();
 	/// Cleans up the globe ruleset.
@@ -48,6 +57,8 @@ public:
 	void load(const YAML::Node& node);
 	/// Gets the list of world polygons.
 	std::list<Polygon*> *getPolygons();
+	/// Gets world polygons that can contain given point.
+	const std::vector<Polygon*> &getPolygonsNear(double lon, double lat);
 	/// Gets the list of world polylines.
 	std::list<Polyline*> *getPolylines();
 	/// Loads a set of polygons from a DAT file.
@@ -57,6 +57,8 @@
 namespace OpenXcom
 {
 
+std::atomic<int> BattleUnit::_unitIndexVersion{ 0 };
+
 /**
  * Initializes a BattleUnit from a Soldier
  * @param soldier Pointer to the Soldier.
@@ -676,6 +678,7 @@ BattleUnit::~BattleUnit()
 	}
 	delete _statistics;
 	delete _currentAIState;
+	++_unitIndexVersion;
 }
 
 /**
@@ -690,6 +693,7 @@ void BattleUnit::load(const YAML::Node &node, const Mod *mod, const ScriptGlobal
 	_wantsToSurrender = node["wantsToSurrender"].as<bool>(_wantsToSurrender);
 	_isSurrendering = node["isSurrendering"].as<bool>(_isSurrendering);
 	_pos = node["position"].as<Position>(_pos);
+	++_unitIndexVersion;
 	_direction = _toDirection = node["direction"].as<int>(_direction);
 	_directionTurret = _toDirectionTurret = node["directionTurret"].as<int>(_directionTurret);
 	_tu = node["tu"].as<int>(_tu);
@@ -1022,6 +1026,7 @@ void BattleUnit::setPosition(Position pos, bool updateLastPos)
 {
 	if (updateLastPos) { _lastPos = _pos; }
 	_pos = pos;
+	++_unitIndexVersion;
 }
 
 /**
@@ -1240,6 +1245,7 @@ void BattleUnit::keepWalking(SavedBattleGame *savedBattleGame, bool fullWalkCycl
 	if (!fullWalkCycle)
 	{
 		_pos = _destination;
+		++_unitIndexVersion;
 		end = 2;
 	}
 
@@ -1250,6 +1256,7 @@ void BattleUnit::keepWalking(SavedBattleGame *savedBattleGame, bool fullWalkCycl
 		// we assume we reached our destination tile
 		// this is actually a drawing hack, so soldiers are not overlapped by floor tiles
 		_pos = _destination;
+		++_unitIndexVersion;
 	}
 
 	if (!fullWalkCycle || (_walkPhase == middle))
@@ -2840,6 +2847,7 @@ void BattleUnit::prepareNewTurn(bool fullProcess)
 	if (_faction != _originalFaction)
 	{
 		_faction = _originalFaction;
+		++_unitIndexVersion;
 		if (_faction == FACTION_PLAYER && _currentAIState)
 		{
 			delete _currentAIState;
@@ -4653,6 +4661,7 @@ const std::string& BattleUnit::getType() const
 void BattleUnit::convertToFaction(UnitFaction f)
 {
 	_faction = f;
+	++_unitIndexVersion;
 }
 
 /**
@@ -20,6 +20,7 @@
 #include <vector>
 #include <string>
 #include <unordered_set>
+#include <atomic>
 #include "../Battlescape/Position.h"
 #include "../Mod/Armor.h"
 #include "../Mod/RuleItem.h"
@@ -87,6 +88,9 @@ class BattleUnit
 {
 private:
 	static const int SPEC_WEAPON_MAX = 3;
+	/// Changes each time any unit is destroyed, moved or changes faction.
+	/// Atomic as AI reads it from worker thread, units are changed only on main thread when AI is not thinking.
+	static std::atomic<int> _unitIndexVersion;
 
 	UnitFaction _faction, _originalFaction;
 	UnitFaction _killedBy;
@@ -243,6 +247,8 @@ public:
 	int distance3dToUnitSq(BattleUnit* otherUnit) const;
 	/// Sets the unit's position
 	void setPosition(Position pos, bool updateLastPos = true);
+	/// Gets counter that changes each time any unit is destroyed, moved or changes faction.
+	static int getUnitIndexVersion() { return _unitIndexVersion; }
 	/// Gets the unit's position.
 	Position getPosition() const;
 	/// Gets the unit's position.
@@ -18,6 +18,7 @@
  */
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 #include "BattleItem.h"
 #include "BattleObject.h"
 #include "ItemContainer.h"
@@ -31,6 +32,7 @@
 #include "../Mod/MapDataSet.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Battlescape/TileEngine.h"
+#include "../fmath.h"
 #include "../Battlescape/BattlescapeState.h"
 #include "../Battlescape/BattlescapeGame.h"
 #include "../Battlescape/Position.h"
@@ -1144,6 +1146,102 @@ std::vector<BattleUnit*> *SavedBattleGame::getUnits()
 	return &_units;
 }
 
+/**
+ * Gets bucket of unit index for position and faction.
+ * Positions outside of the map go to the nearest cell.
+ * @param pos Position on the map.
+ * @param faction Faction of the unit.
+ * @return Index of bucket.
+ */
+int SavedBattleGame::getUnitIndexBucket(Position pos, UnitFaction faction) const
+{
+	const int cellsX = std::max(1, (_mapsize_x + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const int cellsY = std::max(1, (_mapsize_y + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const int x = Clamp(pos.x / UNIT_INDEX_CELL_SIZE, 0, cellsX - 1);
+	const int y = Clamp(pos.y / UNIT_INDEX_CELL_SIZE, 0, cellsY - 1);
+	return (y * cellsX + x) * 3 + faction;
+}
+
+/**
+ * Rebuilds index of units by position and faction if any unit moved, changed faction,
+ * or was added or removed since last time.
+ */
+void SavedBattleGame::updateUnitIndex()
+{
+	const int cellsX = std::max(1, (_mapsize_x + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const int cellsY = std::max(1, (_mapsize_y + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const size_t buckets = cellsX * cellsY * 3;
+	if (_unitIndexVersion == BattleUnit::getUnitIndexVersion() && _unitIndexSize == _units.size() && _unitIndex.size() == buckets)
+	{
+		return;
+	}
+
+	_unitIndex.resize(buckets);
+	for (auto &bucket : _unitIndex)
+	{
+		bucket.clear();
+	}
+	for (size_t i = 0; i < _units.size(); ++i)
+	{
+		_unitIndex[getUnitIndexBucket(_units[i]->getPosition(), _units[i]->getFaction())].push_back((int)i);
+	}
+	_unitIndexVersion = BattleUnit::getUnitIndexVersion();
+	_unitIndexSize = _units.size();
+}
+
+/**
+ * Gets units that could be in given distance from position, in same order as in the list of units.
+ * Index only looks at cells, so result can also contain units that are a bit further,
+ * callers need to check the exact distance like they would with the full list.
+ * @param center Position to search around.
+ * @param radius Max distance on x and y axis, levels are ignored.
+ * @param result Units found.
+ * @param factions Flags of factions to search near the position.
+ * @param factionsAnywhere Flags of factions to take from the whole map.
+ */
+void SavedBattleGame::getUnitsInRadius(Position center, int radius, std::vector<BattleUnit*> &result, int factions, int factionsAnywhere)
+{
+	updateUnitIndex();
+
+	const int cellsX = std::max(1, (_mapsize_x + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const int cellsY = std::max(1, (_mapsize_y + UNIT_INDEX_CELL_SIZE - 1) / UNIT_INDEX_CELL_SIZE);
+	const int minX = Clamp((center.x - radius) / UNIT_INDEX_CELL_SIZE, 0, cellsX - 1);
+	const int maxX = Clamp((center.x + radius) / UNIT_INDEX_CELL_SIZE, 0, cellsX - 1);
+	const int minY = Clamp((center.y - radius) / UNIT_INDEX_CELL_SIZE, 0, cellsY - 1);
+	const int maxY = Clamp((center.y + radius) / UNIT_INDEX_CELL_SIZE, 0, cellsY - 1);
+
+	std::vector<int> found;
+	for (int faction = FACTION_PLAYER; faction <= FACTION_NEUTRAL; ++faction)
+	{
+		const int flag = 1 << faction;
+		if (factionsAnywhere & flag)
+		{
+			for (int i = faction; i < (int)_unitIndex.size(); i += 3)
+			{
+				found.insert(found.end(), _unitIndex[i].begin(), _unitIndex[i].end());
+			}
+		}
+		else if (factions & flag)
+		{
+			for (int y = minY; y <= maxY; ++y)
+			{
+				for (int x = minX; x <= maxX; ++x)
+				{
+					const auto &bucket = _unitIndex[(y * cellsX + x) * 3 + faction];
+					found.insert(found.end(), bucket.begin(), bucket.end());
+				}
+			}
+		}
+	}
+	std::sort(found.begin(), found.end());
+
+	result.clear();
+	for (int i : found)
+	{
+		result.push_back(_units[i]);
+	}
+}
+
 /**
  * Gets the list of items.
  * @return Pointer to the list of items.
@@ -2554,6 +2652,8 @@ void SavedBattleGame::prepareNewTurn()
 						}
 					}
 				}
+				getPathfinding()->invalidateTUCostCache((*i)->getPosition());
+				getTileEngine()->invalidateVoxelCache((*i)->getPosition());
 				getTileEngine()->applyGravity(*i);
 			}
 		}
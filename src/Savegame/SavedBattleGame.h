@@ -80,6 +80,9 @@ private:
 	BattleUnit *_selectedUnit, *_lastSelectedUnit;
 	std::vector<Node*> _nodes;
 	std::vector<BattleUnit*> _units;
+	std::vector<std::vector<int> > _unitIndex;
+	int _unitIndexVersion = -1;
+	size_t _unitIndexSize = 0;
 	std::vector<BattleItem*> _items, _deleted;
 	std::vector<BattleObject*> _battleObjects;
 	int _itemObjectivesNumber;
@@ -139,7 +142,16 @@ private:
 	void newTurnUpdateScripts();
 	/// Updates alarm level on the battlescape.
 	void updateAlarm();
+	/// Gets bucket of unit index for position and faction.
+	int getUnitIndexBucket(Position pos, UnitFaction faction) const;
+	/// Rebuilds unit index if any unit moved since last time.
+	void updateUnitIndex();
 public:
+	/// Size of cell of unit index in tiles.
+	static constexpr int UNIT_INDEX_CELL_SIZE = 8;
+	/// Flags of all factions for unit index queries.
+	static constexpr int UNIT_INDEX_ALL_FACTIONS = 7;
+
 	/// Creates a new battle save, based on the current generic save.
 	SavedBattleGame(Mod *rule, Language *lang, bool isPreview = false);
 	/// Cleans up the saved game.
@@ -233,6 +245,8 @@ public:
 	std::vector<BattleObject*>* getBattleObjects() { return &_battleObjects; };
 	/// Gets a pointer to the list of units.
 	std::vector<BattleUnit*> *getUnits();
+	/// Gets units that could be in given distance from position.
+	void getUnitsInRadius(Position center, int radius, std::vector<BattleUnit*> &result, int factions = UNIT_INDEX_ALL_FACTIONS, int factionsAnywhere = 0);
 	/// Gets terrain size x.
 	int getMapSizeX() const { return _mapsize_x; }
 	/// Gets terrain size y.
@@ -25,6 +25,7 @@
 #include <yaml-cpp/yaml.h>
 #include "../version.h"
 #include "../Engine/Logger.h"
+#include "../fmath.h"
 #include "../Mod/Mod.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Exception.h"
@@ -148,7 +149,7 @@ bool haveReserchVector(const std::vector<const RuleResearch*> &vec,  const std::
  * Initializes a brand new saved game according to the specified difficulty.
  */
 SavedGame::SavedGame() :
-	_difficulty(DIFF_BEGINNER), _end(END_NONE), _ironman(false), _globeLon(0.0), _globeLat(0.0), _globeZoom(0), _battleGame(0),
+	_difficulty(DIFF_BEGINNER), _end(END_NONE), _ironman(false), _globeLon(0.0), _globeLat(0.0), _globeZoom(0), _regionCellsCount(0), _countryCellsCount(0), _battleGame(0),
 	_previewBase(nullptr), _debug(false), _warned(false), _ftaGame(false),
 	_togglePersonalLight(true), _toggleNightVision(false), _toggleBrightness(0),
 	_monthsPassed(-1), _loyalty(0), _lastMonthsLoyalty(0), _selectedBase(0), _autosales(),
@@ -2793,6 +2794,83 @@ void SavedGame::setWarned(bool warned)
 	_warned = warned;
 }
 
+namespace
+{
+
+/// Size of a globe cell used to look up regions and countries, in degrees.
+const int GLOBE_CELL_SIZE = 5;
+const int GLOBE_CELLS_LON = 360 / GLOBE_CELL_SIZE;
+const int GLOBE_CELLS_LAT = 180 / GLOBE_CELL_SIZE;
+
+/**
+ * Lists for each globe cell the regions or countries with an area touching it.
+ * Cells are slightly enlarged so rounding at their edges can't lose a candidate,
+ * and each list keeps the original order, so the first match stays the same.
+ * @param list Regions or countries to index.
+ * @param cells Cells to fill.
+ */
+template<typename T>
+void buildGlobeCells(const std::vector<T*> &list, std::vector<std::vector<T*>> &cells)
+{
+	const double cellSize = GLOBE_CELL_SIZE * M_PI / 180.0;
+	const double margin = 1e-6;
+	cells.clear();
+	cells.resize(GLOBE_CELLS_LON * GLOBE_CELLS_LAT);
+	for (int y = 0; y < GLOBE_CELLS_LAT; ++y)
+	{
+		const double cellLatMin = y * cellSize - M_PI_2 - margin;
+		const double cellLatMax = (y + 1) * cellSize - M_PI_2 + margin;
+		for (int x = 0; x < GLOBE_CELLS_LON; ++x)
+		{
+			const double cellLonMin = x * cellSize - margin;
+			const double cellLonMax = (x + 1) * cellSize + margin;
+			for (auto* item : list)
+			{
+				auto* rule = item->getRules();
+				for (size_t i = 0; i < rule->getLonMin().size(); ++i)
+				{
+					const double lonMin = rule->getLonMin()[i];
+					const double lonMax = rule->getLonMax()[i];
+					bool inLat = rule->getLatMin()[i] <= cellLatMax && rule->getLatMax()[i] >= cellLatMin;
+					bool inLon;
+					if (lonMin <= lonMax)
+						inLon = lonMin <= cellLonMax && lonMax >= cellLonMin;
+					else
+						inLon = lonMin <= cellLonMax || lonMax >= cellLonMin;
+					if (inLon && inLat)
+					{
+						cells[y * GLOBE_CELLS_LON + x].push_back(item);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Gets the regions or countries that could contain a point.
+ * @param list All regions or countries, used for points outside of the globe range.
+ * @param cells Cells built by buildGlobeCells.
+ * @param lon The longitude.
+ * @param lat The latitude.
+ * @return Candidates in their original order.
+ */
+template<typename T>
+const std::vector<T*> &getGlobeCell(const std::vector<T*> &list, const std::vector<std::vector<T*>> &cells, double lon, double lat)
+{
+	if (!(lon >= 0.0 && lon < M_PI * 2.0 && lat >= -M_PI_2 && lat <= M_PI_2))
+	{
+		return list;
+	}
+	const double cellSize = GLOBE_CELL_SIZE * M_PI / 180.0;
+	int x = Clamp((int)(lon / cellSize), 0, GLOBE_CELLS_LON - 1);
+	int y = Clamp((int)((lat + M_PI_2) / cellSize), 0, GLOBE_CELLS_LAT - 1);
+	return cells[y * GLOBE_CELLS_LON + x];
+}
+
+}
+
 /** @brief Check if a point is contained in a region.
  * This function object checks if a point is contained inside a region.
  */
@@ -2818,15 +2896,38 @@ private:
  */
 Region *SavedGame::locateRegion(double lon, double lat) const
 {
-	std::vector<Region *>::const_iterator found = std::find_if (_regions.begin(), _regions.end(), ContainsPoint(lon, lat));
-	if (found != _regions.end())
+	Region *found = getRegionAt(lon, lat);
+	if (found)
 	{
-		return *found;
+		return found;
 	}
 	Log(LOG_ERROR) << "Failed to find a region at location [" << lon << ", " << lat << "].";
 	return 0;
 }
 
+/**
+ * Find the region containing this location.
+ * Same as locateRegion, but a point outside of all regions is not an error.
+ * @param lon The longitude.
+ * @param lat The latitude.
+ * @return Pointer to the region, or 0.
+ */
+Region *SavedGame::getRegionAt(double lon, double lat) const
+{
+	if (_regionCells.empty() || _regionCellsCount != _regions.size())
+	{
+		buildGlobeCells(_regions, _regionCells);
+		_regionCellsCount = _regions.size();
+	}
+	const std::vector<Region*> &candidates = getGlobeCell(_regions, _regionCells, lon, lat);
+	std::vector<Region *>::const_iterator found = std::find_if (candidates.begin(), candidates.end(), ContainsPoint(lon, lat));
+	if (found != candidates.end())
+	{
+		return *found;
+	}
+	return 0;
+}
+
 /**
  * Find the region containing this target.
  * @param target The target to locate.
@@ -2862,8 +2963,14 @@ private:
  */
 Country* SavedGame::locateCountry(double lon, double lat) const
 {
-	std::vector<Country*>::const_iterator found = std::find_if(_countries.begin(), _countries.end(), CountryContainsPoint(lon, lat));
-	if (found != _countries.end())
+	if (_countryCells.empty() || _countryCellsCount != _countries.size())
+	{
+		buildGlobeCells(_countries, _countryCells);
+		_countryCellsCount = _countries.size();
+	}
+	const std::vector<Country*> &candidates = getGlobeCell(_countries, _countryCells, lon, lat);
+	std::vector<Country*>::const_iterator found = std::find_if(candidates.begin(), candidates.end(), CountryContainsPoint(lon, lat));
+	if (found != candidates.end())
 	{
 		return *found;
 	}
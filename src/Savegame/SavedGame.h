@@ -150,6 +150,10 @@ private:
 	std::map<std::string, int> _ids;
 	std::vector<Country*> _countries;
 	std::vector<Region*> _regions;
+	/// Regions and countries that can contain a point of each globe cell, built on first lookup.
+	mutable std::vector<std::vector<Region*>> _regionCells;
+	mutable std::vector<std::vector<Country*>> _countryCells;
+	mutable size_t _regionCellsCount, _countryCellsCount;
 	std::vector<Base*> _bases;
 	std::vector<Ufo*> _ufos;
 	std::vector<Waypoint*> _waypoints;
@@ -451,6 +455,8 @@ public:
 	const std::vector<DiplomacyFaction*>& getDiplomacyFactions() const { return _diplomacyFactions; }
 	/// Locate a region containing a position.
 	Region *locateRegion(double lon, double lat) const;
+	/// Locate a region containing a position, without reporting failure.
+	Region *getRegionAt(double lon, double lat) const;
 	/// Locate a region containing a Target.
 	Region *locateRegion(const Target &target) const;
 	/// Locate a country containing a position.
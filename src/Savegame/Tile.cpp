@@ -716,9 +716,11 @@ void Tile::ignite(int power)
  * Animate the tile. This means to advance the current frame for every object.
  * Ufo doors are a bit special, they animated only when triggered.
  * When ufo doors are on frame 0(closed) or frame 7(open) they are not animated further.
+ * @return True if any ufo door changed its frame.
  */
-void Tile::animate()
+bool Tile::animate()
 {
+	bool ufoDoorChanged = false;
 	int newframe;
 	for (int i = O_FLOOR; i < O_MAX; ++i)
 	{
@@ -738,9 +740,11 @@ void Tile::animate()
 				newframe = 0;
 			}
 			_objectsCache[i].currentFrame = newframe;
+			ufoDoorChanged |= (bool)_objectsCache[i].isUfoDoor;
 		}
 		updateSprite((TilePart)i);
 	}
+	return ufoDoorChanged;
 }
 
 /**
@@ -309,7 +309,7 @@ public:
 	/// Get explosive power of this tile.
 	int getExplosiveType() const;
 	/// Animated the tile parts.
-	void animate();
+	bool animate();
 	/// Update cached value of sprite.
 	void updateSprite(TilePart part);
 	/// Get object sprites.